@@ -7,6 +7,7 @@
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -214,6 +215,13 @@ disk_size (struct disk *d) {
 	return d->capacity;
 }
 
+/* Returns D's number for tracepoints: CHAN_NO * 2 + DEV_NO, so
+   that 3 is hd1:1. */
+static int
+disk_trace_id (const struct disk *d) {
+	return (d->channel - channels) * 2 + d->dev_no;
+}
+
 /* Reads sector SEC_NO from disk D into BUFFER, which must have
    room for DISK_SECTOR_SIZE bytes.
    Internally synchronizes accesses to disks, so external
@@ -232,6 +240,7 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
 	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
+	trace (TRACE_DISK_ISSUE, sec_no, disk_trace_id (d) * 2);
 	sema_down (&c->completion_wait);
 	if (!wait_while_busy (d))
 		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
@@ -257,6 +266,7 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
 	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
+	trace (TRACE_DISK_ISSUE, sec_no, disk_trace_id (d) * 2 + 1);
 	if (!wait_while_busy (d))
 		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
 	output_sector (c, buffer);
@@ -535,6 +545,7 @@ interrupt_handler (struct intr_frame *f) {
 		if (f->vec_no == c->irq) {
 			if (c->expecting_interrupt) {
 				inb (reg_status (c));               /* Acknowledge interrupt. */
+				trace (TRACE_DISK_DONE, c - channels, 0);
 				sema_up (&c->completion_wait);      /* Wake up waiter. */
 			} else
 				printf ("%s: unexpected interrupt\n", c->name);
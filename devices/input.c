@@ -6,10 +6,14 @@
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
 
+/* Threads in input_wait(). */
+static struct wait_queue readers;
+
 /* Initializes the input buffer. */
 void
 input_init (void) {
 	intq_init (&buffer);
+	wait_queue_init (&readers);
 }
 
 /* Adds a key to the input buffer.
@@ -21,6 +25,7 @@ input_putc (uint8_t key) {
 
 	intq_putc (&buffer, key);
 	serial_notify ();
+	wake_up (&readers);
 }
 
 /* Retrieves a key from the input buffer.
@@ -39,6 +44,33 @@ input_getc (void) {
 	return key;
 }
 
+struct input_wait_args {
+	wait_pred *stop;
+	void *aux;
+};
+
+static bool
+input_ready (void *args_) {
+	struct input_wait_args *args = args_;
+	return !intq_empty (&buffer) || args->stop (args->aux);
+}
+
+/* Waits until a key is in the input buffer or STOP (AUX) returns true,
+   whichever comes first.  Returns true if a key is there, so that
+   input_getc() will not block, as long as no one else takes it. */
+bool
+input_wait (wait_pred *stop, void *aux) {
+	struct input_wait_args args = { stop, aux };
+	enum intr_level old_level;
+	bool ready;
+
+	wait_event (&readers, input_ready, &args);
+	old_level = intr_disable ();
+	ready = !intq_empty (&buffer);
+	intr_set_level (old_level);
+	return ready;
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
@@ -5,8 +5,10 @@
 #include <stdio.h>
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -29,24 +31,79 @@ static bool too_many_loops(unsigned loops);
 void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
 
-static struct list sleeping_list;
+/* Pending timer events live in a hierarchical timing wheel.  Events due
+   within the next TVR_SIZE ticks sit in tv1, one bucket per tick.  Later
+   events sit in one of the coarser levels tvn[0..2], whose buckets cover
+   TVR_SIZE, TVR_SIZE * TVN_SIZE and TVR_SIZE * TVN_SIZE^2 ticks.  Each
+   time tv1 wraps, the next bucket of a coarser level is cascaded down.
+   Adding and cancelling are O(1).  Each tick touches only the bucket
+   that is due, plus a cascade every TVR_SIZE ticks. */
+#define TVR_BITS 8
+#define TVN_BITS 6
+#define TVR_SIZE (1 << TVR_BITS)
+#define TVN_SIZE (1 << TVN_BITS)
+#define TVR_MASK (TVR_SIZE - 1)
+#define TVN_MASK (TVN_SIZE - 1)
+#define TVN_LEVELS 3
+#define WHEEL_MAX_DELTA ((1LL << (TVR_BITS + TVN_LEVELS * TVN_BITS)) - 1)
+
+static struct list tv1[TVR_SIZE];
+static struct list tvn[TVN_LEVELS][TVN_SIZE];
+
+static void wheel_add(struct timer_event *, int64_t base);
+static void run_timers(void);
+
+/* 8254 input frequency, and the counter value for one timer tick. */
+#define PIT_HZ 1193180
+#define PIT_TICK_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* TSC frequency and TSC cycles per tick, measured by timer_calibrate().
+   Zero until then; hrtimers and tickless idle need them. */
+static uint64_t tsc_hz;
+static uint64_t tsc_per_tick;
+static uint64_t tsc_boot;
+
+/* Number of ticks timer_calibrate() measures the TSC over. */
+#define TSC_CALIBRATE_TICKS 4
+
+/* Pending hrtimers, sorted by TSC deadline. */
+static struct list hrtimer_list;
+
+/* Sleeps shorter than this spin on the TSC instead of blocking, since
+   blocking and waking would take about as long. */
+#define HRTIMER_MIN_SLEEP_NS 20000
+
+/* The PIT runs in periodic mode, one interrupt per tick, until an hrtimer
+   falls due between two ticks or the CPU goes idle.  It then switches to
+   one-shot mode and is programmed for each next event: the next tick at
+   NEXT_TICK_TSC, the earliest hrtimer, or (when idle) the next tick with
+   timer-wheel work.  Ticks are then counted from the TSC.  It returns to
+   periodic mode at a tick boundary once nothing sub-tick is pending. */
+static bool oneshot;
+static uint64_t next_tick_tsc;
+
+/* Longest interval the 16-bit PIT counter can time. */
+#define PIT_MAX_COUNT 0xffff
+
+static void pit_periodic(void);
+static void tick_once(void);
+static void clockevent_program(bool idle);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
    corresponding interrupt. */
 void timer_init(void)
 {
-  /* 8254 input frequency divided by TIMER_FREQ, rounded to
-     nearest. */
-  uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-
-  outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
-  outb(0x40, count & 0xff);
-  outb(0x40, count >> 8);
+  pit_periodic();
 
   intr_register_ext(0x20, timer_interrupt, "8254 Timer");
 
-  list_init(&sleeping_list); // 리스트 초기화 시킴
+  for (int i = 0; i < TVR_SIZE; i++)
+    list_init(&tv1[i]);
+  for (int lvl = 0; lvl < TVN_LEVELS; lvl++)
+    for (int i = 0; i < TVN_SIZE; i++)
+      list_init(&tvn[lvl][i]);
+  list_init(&hrtimer_list);
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
@@ -73,6 +130,57 @@ void timer_calibrate(void)
       loops_per_tick |= test_bit;
 
   printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
+
+  /* Count TSC cycles over a few whole ticks. */
+  int64_t start = ticks;
+  while (ticks == start)
+    barrier();
+  uint64_t tsc_start = rdtsc();
+  start = ticks;
+  while (ticks < start + TSC_CALIBRATE_TICKS)
+    barrier();
+  uint64_t cycles = rdtsc() - tsc_start;
+
+  enum intr_level old_level = intr_disable();
+  tsc_per_tick = cycles / TSC_CALIBRATE_TICKS;
+  tsc_hz = tsc_per_tick * TIMER_FREQ;
+  tsc_boot = rdtsc();
+  intr_set_level(old_level);
+  printf("TSC: %'" PRIu64 " Hz.\n", tsc_hz);
+}
+
+/* Returns the raw time-stamp counter. */
+uint64_t
+timer_tsc(void)
+{
+  return rdtsc();
+}
+
+/* Converts a TSC interval to nanoseconds.  Returns 0 before
+   timer_calibrate(). */
+int64_t
+timer_tsc_to_ns(uint64_t cycles)
+{
+  if (tsc_hz == 0)
+    return 0;
+  return cycles / tsc_hz * 1000000000 + cycles % tsc_hz * 1000000000 / tsc_hz;
+}
+
+/* Returns nanoseconds since timer_calibrate(), for timestamps and
+   profiling.  Returns 0 before then. */
+int64_t
+timer_ns(void)
+{
+  return timer_tsc_to_ns(rdtsc() - tsc_boot);
+}
+
+/* Converts NS nanoseconds to TSC cycles. */
+static uint64_t
+ns_to_tsc(int64_t ns)
+{
+  if (ns <= 0)
+    return 0;
+  return ns / 1000000000 * tsc_hz + ns % 1000000000 * tsc_hz / 1000000000;
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -94,20 +202,127 @@ timer_elapsed(int64_t then)
   return timer_ticks() - then;
 }
 
+/* Initializes timer event EV to call FUNC (AUX) when it fires. */
+void timer_event_init(struct timer_event *ev, timer_func *func, void *aux)
+{
+  ev->func = func;
+  ev->aux = aux;
+  ev->pending = false;
+}
+
+/* Arms EV to fire at tick EXPIRES, or at the next tick if EXPIRES has
+   already passed.  EV must not already be pending.  May be called from
+   an interrupt handler, including from another event's FUNC. */
+void timer_event_add(struct timer_event *ev, int64_t expires)
+{
+  enum intr_level old_level = intr_disable();
+
+  ASSERT(!ev->pending);
+  ev->expires = expires;
+  ev->pending = true;
+  wheel_add(ev, ticks + 1);
+  intr_set_level(old_level);
+}
+
+/* Disarms EV.  Returns true if EV was pending, false if it had already
+   fired or was never armed. */
+bool timer_event_cancel(struct timer_event *ev)
+{
+  enum intr_level old_level = intr_disable();
+  bool was_pending = ev->pending;
+
+  if (was_pending)
+  {
+    list_remove(&ev->elem);
+    ev->pending = false;
+  }
+  intr_set_level(old_level);
+  return was_pending;
+}
+
+/* Orders hrtimers by deadline. */
+static bool
+hrtimer_less(const struct list_elem *a, const struct list_elem *b,
+             void *aux UNUSED)
+{
+  return list_entry(a, struct hrtimer, elem)->deadline
+         < list_entry(b, struct hrtimer, elem)->deadline;
+}
+
+/* Initializes hrtimer T to call FUNC (AUX) when it fires. */
+void hrtimer_init(struct hrtimer *t, timer_func *func, void *aux)
+{
+  t->func = func;
+  t->aux = aux;
+  t->pending = false;
+}
+
+/* Returns true once the TSC is calibrated, so that hrtimer_start() may
+   be used. */
+bool hrtimer_available(void)
+{
+  return tsc_hz != 0;
+}
+
+/* Arms T to fire NS nanoseconds from now, with sub-tick precision.  T
+   must not already be pending, and timer_calibrate() must have run.  May
+   be called from an interrupt handler. */
+void hrtimer_start(struct hrtimer *t, int64_t ns)
+{
+  enum intr_level old_level = intr_disable();
+
+  ASSERT(tsc_hz != 0);
+  ASSERT(!t->pending);
+  t->deadline = rdtsc() + ns_to_tsc(ns);
+  t->pending = true;
+  list_insert_ordered(&hrtimer_list, &t->elem, hrtimer_less, NULL);
+
+  /* A new earliest deadline may need an interrupt before the next
+     tick. */
+  if (list_front(&hrtimer_list) == &t->elem)
+    clockevent_program(false);
+  intr_set_level(old_level);
+}
+
+/* Disarms T.  Returns true if T was pending, false if it had already
+   fired or was never armed. */
+bool hrtimer_cancel(struct hrtimer *t)
+{
+  enum intr_level old_level = intr_disable();
+  bool was_pending = t->pending;
+
+  if (was_pending)
+  {
+    list_remove(&t->elem);
+    t->pending = false;
+  }
+  intr_set_level(old_level);
+  return was_pending;
+}
+
+/* Wakes sleeping thread T from a timer callback, preempting the
+   interrupted thread if the scheduler says T should run first. */
+static void
+wake_sleeper(void *t_)
+{
+  struct thread *t = t_;
+
+  thread_unblock(t);
+  if (thread_should_preempt(t))
+    intr_yield_on_return();
+}
+
 /* Suspends execution for approximately TICKS timer ticks. */
 void timer_sleep(int64_t ticks)
 {
   int64_t start = timer_ticks();
-  int64_t wakeup_tick = start + ticks; // 언제 깨어날지
+  struct timer_event ev;
 
   ASSERT(intr_get_level() == INTR_ON);
 
-  thread_current()->wakeup_tick = wakeup_tick; // 깨어날 시각 저장
+  timer_event_init(&ev, wake_sleeper, thread_current());
   enum intr_level old_level = intr_disable();  // 인터럽트 비활성화 시킴
-
-  // 일어나야할 친구들을 오름차순으로 정렬 후에 삽입
-  list_insert_ordered(&sleeping_list, &thread_current()->elem, earlier_wake_up, NULL);
-
+  timer_event_add(&ev, start + ticks);
   thread_block();            // 현재 스레드 block 시킴 (깨울때까지 잠들어있도록)
   intr_set_level(old_level); // 인터럽트 원래대로 복구 시킴
 }
@@ -136,34 +351,263 @@ void timer_print_stats(void)
   printf("Timer: %" PRId64 " ticks\n", timer_ticks());
 }
 
-static void check_sleeping_threads(void)
+/* Files EV into the wheel bucket for its expiry, where BASE is the
+   earliest tick the wheel has not yet processed. */
+static void
+wheel_add(struct timer_event *ev, int64_t base)
 {
-  while (!list_empty(&sleeping_list))
+  int64_t expires = ev->expires < base ? base : ev->expires;
+  int64_t delta = expires - base;
+  struct list *bucket;
+
+  if (delta < TVR_SIZE)
+    bucket = &tv1[expires & TVR_MASK];
+  else
   {
-    struct list_elem *e = list_front(&sleeping_list);
-    struct thread *t = list_entry(e, struct thread, elem);
+    int lvl;
+
+    /* Too far out for the wheel: park it in the last bucket of the top
+       level, from which it is cascaded back up until it fits. */
+    if (delta > WHEEL_MAX_DELTA)
+      expires = base + WHEEL_MAX_DELTA;
+    delta = expires - base;
+    for (lvl = 0; lvl < TVN_LEVELS - 1; lvl++)
+      if (delta < 1LL << (TVR_BITS + (lvl + 1) * TVN_BITS))
+        break;
+    bucket = &tvn[lvl][(expires >> (TVR_BITS + lvl * TVN_BITS)) & TVN_MASK];
+  }
+  list_push_back(bucket, &ev->elem);
+}
 
-    if (t->wakeup_tick <= ticks)
-    {
-      list_pop_front(&sleeping_list);
-      thread_unblock(t);
-    }
-    else
-    {
-      break;
-    }
+/* Re-files every event in bucket INDEX of level LVL, which is now due to
+   be spread over the finer levels.  Returns INDEX. */
+static int
+cascade(int lvl, int index)
+{
+  struct list *bucket = &tvn[lvl][index];
+  struct list pending;
+
+  list_init(&pending);
+  while (!list_empty(bucket))
+    list_push_back(&pending, list_pop_front(bucket));
+  while (!list_empty(&pending))
+    wheel_add(list_entry(list_pop_front(&pending), struct timer_event, elem),
+              ticks);
+  return index;
+}
+
+/* Fires the events due at the current tick.  Runs once per tick, after
+   TICKS has been advanced. */
+static void
+run_timers(void)
+{
+  int index = ticks & TVR_MASK;
+  struct list *bucket = &tv1[index];
+
+  /* tv1 just wrapped: pull the next bucket of each coarser level down,
+     stopping at the first level that did not wrap itself. */
+  if (index == 0)
+    for (int lvl = 0; lvl < TVN_LEVELS; lvl++)
+      if (cascade(lvl, (ticks >> (TVR_BITS + lvl * TVN_BITS)) & TVN_MASK) != 0)
+        break;
+
+  /* Events are appended, so same-tick events fire in the order added. */
+  while (!list_empty(bucket))
+  {
+    struct timer_event *ev =
+        list_entry(list_pop_front(bucket), struct timer_event, elem);
+    ev->pending = false;
+    ev->func(ev->aux);
   }
 }
 
-/* Timer interrupt handler. */
+/* Advances the clock by one tick. */
 static void
-timer_interrupt(struct intr_frame *args UNUSED)
+tick_once(void)
 {
-  
   ticks++;
   thread_tick();
 
-  check_sleeping_threads();
+  run_timers();
+}
+
+/* Programs PIT counter 0 to interrupt every tick. */
+static void
+pit_periodic(void)
+{
+  outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
+  outb(0x40, PIT_TICK_COUNT & 0xff);
+  outb(0x40, PIT_TICK_COUNT >> 8);
+}
+
+/* Programs PIT counter 0 to interrupt once, COUNT input cycles from
+   now. */
+static void
+pit_oneshot(uint16_t count)
+{
+  outb(0x43, 0x30); /* CW: counter 0, LSB then MSB, mode 0, binary. */
+  outb(0x40, count & 0xff);
+  outb(0x40, count >> 8);
+}
+
+/* Returns the current value of PIT counter 0. */
+static uint16_t
+pit_read(void)
+{
+  uint8_t lo, hi;
+
+  outb(0x43, 0x00); /* Latch counter 0. */
+  lo = inb(0x40);
+  hi = inb(0x40);
+  return (hi << 8) | lo;
+}
+
+/* Returns how many ticks may pass before the wheel needs servicing:
+   the distance to the next non-empty tv1 bucket or the next tv1 wrap. */
+static int
+idle_horizon(void)
+{
+  int n;
+
+  for (n = 1; n < TVR_SIZE; n++)
+  {
+    int64_t t = ticks + n;
+    if ((t & TVR_MASK) == 0 || !list_empty(&tv1[t & TVR_MASK]))
+      break;
+  }
+  return n;
+}
+
+/* Switches the PIT to one-shot mode, taking the time of the next tick
+   from the part of the current period still to run. */
+static void
+enter_oneshot(void)
+{
+  if (oneshot)
+    return;
+  next_tick_tsc = rdtsc() + (uint64_t)pit_read() * tsc_hz / PIT_HZ;
+  oneshot = true;
+}
+
+/* In one-shot mode, runs every tick whose time has come.  Returns the
+   number of ticks run. */
+static int
+catch_up_ticks(void)
+{
+  uint64_t now = rdtsc();
+  int n = 0;
+
+  while (now >= next_tick_tsc)
+  {
+    next_tick_tsc += tsc_per_tick;
+    tick_once();
+    n++;
+  }
+  return n;
+}
+
+/* Runs every hrtimer whose deadline has passed. */
+static void
+run_hrtimers(void)
+{
+  while (!list_empty(&hrtimer_list))
+  {
+    struct hrtimer *t = list_entry(list_front(&hrtimer_list),
+                                   struct hrtimer, elem);
+    if (t->deadline > rdtsc())
+      break;
+    list_pop_front(&hrtimer_list);
+    t->pending = false;
+    t->func(t->aux);
+  }
+}
+
+/* Programs the PIT for the next event.  In periodic mode this is only
+   needed when the earliest hrtimer falls before the next tick.  With
+   IDLE, the ticks before the next timer-wheel work are skipped. */
+static void
+clockevent_program(bool idle)
+{
+  uint64_t now, deadline;
+
+  if (tsc_hz == 0)
+    return;
+  if (!oneshot)
+  {
+    if (!idle && (list_empty(&hrtimer_list)
+                  || list_entry(list_front(&hrtimer_list), struct hrtimer,
+                                elem)->deadline
+                         >= rdtsc() + tsc_per_tick))
+      return;
+    enter_oneshot();
+  }
+
+  deadline = next_tick_tsc;
+  if (idle)
+    deadline += (idle_horizon() - 1) * tsc_per_tick;
+  if (!list_empty(&hrtimer_list))
+  {
+    uint64_t hr = list_entry(list_front(&hrtimer_list), struct hrtimer,
+                             elem)->deadline;
+    if (hr < deadline)
+      deadline = hr;
+  }
+
+  now = rdtsc();
+  uint64_t count = deadline > now ? (deadline - now) * PIT_HZ / tsc_hz : 0;
+  if (count < 1)
+    count = 1;
+  if (count > PIT_MAX_COUNT)
+    count = PIT_MAX_COUNT;
+  pit_oneshot(count);
+}
+
+/* Called by the idle thread, with interrupts off, just before it halts.
+   Stops the periodic tick until the next timer event is due. */
+void timer_idle_enter(void)
+{
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (tsc_hz == 0 || idle_horizon() <= 1)
+    return;
+  enter_oneshot();
+  clockevent_program(true);
+}
+
+/* Called on every external interrupt other than the timer's.  If the
+   PIT is in one-shot mode, runs the ticks and hrtimers that came due
+   while the CPU was halted, so the interrupted handler sees the right
+   time, and reprograms the PIT for a busy CPU. */
+void timer_idle_exit(void)
+{
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (!oneshot)
+    return;
+
+  catch_up_ticks();
+  run_hrtimers();
+  clockevent_program(false);
+}
+
+/* Timer interrupt handler. */
+static void
+timer_interrupt(struct intr_frame *args)
+{
+  if (!oneshot)
+    tick_once();
+  else if (catch_up_ticks() > 0
+           && (list_empty(&hrtimer_list)
+               || list_entry(list_front(&hrtimer_list), struct hrtimer,
+                             elem)->deadline >= next_tick_tsc))
+  {
+    /* At a tick boundary with nothing due before the next tick: go back
+       to periodic mode, in phase with the tick just run. */
+    oneshot = false;
+    pit_periodic();
+  }
+
+  run_hrtimers();
+  clockevent_program(false);
+  profile_sample(args);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -199,6 +643,19 @@ busy_wait(int64_t loops)
     barrier();
 }
 
+/* Blocks for NS nanoseconds on an hrtimer. */
+static void
+hr_sleep(int64_t ns)
+{
+  struct hrtimer t;
+
+  hrtimer_init(&t, wake_sleeper, thread_current());
+  enum intr_level old_level = intr_disable();
+  hrtimer_start(&t, ns);
+  thread_block();
+  intr_set_level(old_level);
+}
+
 /* Sleep for approximately NUM/DENOM seconds. */
 static void
 real_time_sleep(int64_t num, int32_t denom)
@@ -212,7 +669,21 @@ real_time_sleep(int64_t num, int32_t denom)
   int64_t ticks = num * TIMER_FREQ / denom;
 
   ASSERT(intr_get_level() == INTR_ON);
-  if (ticks > 0)
+  if (tsc_hz != 0)
+  {
+    /* Precise sleep against the TSC: block on an hrtimer, or spin if
+       the sleep is too short to be worth a context switch. */
+    int64_t ns = num * (1000000000 / denom);
+    if (ns >= HRTIMER_MIN_SLEEP_NS)
+      hr_sleep(ns);
+    else
+    {
+      uint64_t end = rdtsc() + ns_to_tsc(ns);
+      while (rdtsc() < end)
+        barrier();
+    }
+  }
+  else if (ticks > 0)
   {
     /* We're waiting for at least one full timer tick.  Use
        timer_sleep() because it will yield the CPU to other
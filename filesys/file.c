@@ -23,6 +23,7 @@ file_open (struct inode *inode) {
 		file->inode = inode;
 		file->pos = 0;
 		file->deny_write = false;
+		file->ref_cnt = 1;
 		return file;
 	} else {
 		inode_close (inode);
@@ -51,10 +52,21 @@ file_duplicate (struct file *file) {
 	return nfile;
 }
 
-/* Closes FILE. */
+/* Takes another reference to FILE, so that it outlives a
+ * file_close() by someone else until the matching file_close()
+ * of ours.  Returns FILE. */
+struct file *
+file_get (struct file *file) {
+	if (file != NULL)
+		__atomic_add_fetch (&file->ref_cnt, 1, __ATOMIC_RELAXED);
+	return file;
+}
+
+/* Drops a reference to FILE, closing it with the last one. */
 void
 file_close (struct file *file) {
-	if (file != NULL) {
+	if (file != NULL
+			&& __atomic_sub_fetch (&file->ref_cnt, 1, __ATOMIC_ACQ_REL) == 0) {
 		file_allow_write (file);
 		inode_close (file->inode);
 		free (file);
@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/rcu.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -53,13 +54,16 @@ byte_to_sector (const struct inode *inode, off_t pos) {
 }
 
 /* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
+ * returns the same `struct inode'.
+ * Looked up under RCU; changes are serialized by open_inodes_lock. */
 static struct list open_inodes;
+static struct lock open_inodes_lock;
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	lock_init (&open_inodes_lock);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -99,38 +103,76 @@ inode_create (disk_sector_t sector, off_t length) {
 	return success;
 }
 
+/* Takes a reference to INODE, unless its last opener is already
+ * closing it. */
+static bool
+inode_get_unless_zero (struct inode *inode) {
+	int cnt = __atomic_load_n (&inode->open_cnt, __ATOMIC_RELAXED);
+
+	do {
+		if (cnt == 0)
+			return false;
+	} while (!__atomic_compare_exchange_n (&inode->open_cnt, &cnt, cnt + 1,
+				false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+	return true;
+}
+
+/* Returns the open inode for SECTOR with a new reference taken, or a
+ * null pointer if there is none. */
+static struct inode *
+inode_lookup (disk_sector_t sector) {
+	struct list_elem *e;
+	struct inode *found = NULL;
+
+	rcu_read_lock ();
+	for (e = list_begin_rcu (&open_inodes); e != list_end (&open_inodes);
+			e = list_next_rcu (e)) {
+		struct inode *inode = list_entry (e, struct inode, elem);
+		if (inode->sector == sector && inode_get_unless_zero (inode)) {
+			found = inode;
+			break;
+		}
+	}
+	rcu_read_unlock ();
+	return found;
+}
+
 /* Reads an inode from SECTOR
  * and returns a `struct inode' that contains it.
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
-	struct inode *inode;
+	struct inode *inode, *new;
 
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-					//printf("here\n");
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
-	}
+	inode = inode_lookup (sector);
+	if (inode != NULL)
+		return inode;
+
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	new = malloc (sizeof *new);
+	if (new == NULL)
 		return NULL;
 
 	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
-	inode->sector = sector;
-	inode->open_cnt = 1;
-	inode->deny_write_cnt = 0;
-	inode->removed = false;
+	new->sector = sector;
+	new->open_cnt = 1;
+	new->deny_write_cnt = 0;
+	new->removed = false;
 	/* sync */
-	lock_init(&inode->inode_lock);
-	disk_read (filesys_disk, inode->sector, &inode->data);
+	lock_init(&new->inode_lock);
+	disk_read (filesys_disk, new->sector, &new->data);
+
+	/* Publish it, unless someone opened SECTOR while we read. */
+	lock_acquire (&open_inodes_lock);
+	inode = inode_lookup (sector);
+	if (inode == NULL) {
+		list_push_front_rcu (&open_inodes, &new->elem);
+		inode = new;
+		new = NULL;
+	}
+	lock_release (&open_inodes_lock);
+	free (new);
 	return inode;
 }
 
@@ -138,7 +180,7 @@ inode_open (disk_sector_t sector) {
 struct inode *
 inode_reopen (struct inode *inode) {
 	if (inode != NULL)
-		inode->open_cnt++;
+		__atomic_add_fetch (&inode->open_cnt, 1, __ATOMIC_RELAXED);
 	return inode;
 }
 
@@ -148,6 +190,11 @@ inode_get_inumber (const struct inode *inode) {
 	return inode->sector;
 }
 
+static void
+inode_free_rcu (struct rcu_head *head) {
+	free ((uint8_t *) head - offsetof (struct inode, rcu));
+}
+
 /* Closes INODE and writes it to disk.
  * If this was the last reference to INODE, frees its memory.
  * If INODE was also a removed inode, frees its blocks. */
@@ -158,9 +205,11 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
+	if (__atomic_sub_fetch (&inode->open_cnt, 1, __ATOMIC_ACQ_REL) == 0) {
 		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
+		lock_acquire (&open_inodes_lock);
+		list_remove_rcu (&inode->elem);
+		lock_release (&open_inodes_lock);
 
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
@@ -169,7 +218,8 @@ inode_close (struct inode *inode) {
 					bytes_to_sectors (inode->data.length)); 
 		}
 
-		free (inode); 
+		/* inode_lookup() may still be looking at it. */
+		call_rcu (&inode->rcu, inode_free_rcu);
 	}
 }
 
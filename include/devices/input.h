@@ -3,10 +3,12 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "threads/synch.h"
 
 void input_init (void);
 void input_putc (uint8_t);
 uint8_t input_getc (void);
+bool input_wait (wait_pred *stop, void *aux);
 bool input_full (void);
 
 #endif /* devices/input.h */
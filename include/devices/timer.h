@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -14,6 +16,41 @@ void timer_calibrate (void);
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
 
+/* A one-shot timer.  Once armed with timer_event_add(), FUNC (AUX) is
+   called from the timer interrupt handler at the first tick on or after
+   EXPIRES, unless the event is cancelled first. */
+typedef void timer_func (void *aux);
+struct timer_event {
+	int64_t expires;            /* Tick at which to fire. */
+	timer_func *func;           /* Called in interrupt context. */
+	void *aux;
+	bool pending;               /* Armed and not yet fired. */
+	struct list_elem elem;      /* Element in a timer wheel bucket. */
+};
+
+/* A one-shot high-resolution timer, driven by TSC deadlines.  FUNC (AUX)
+   is called from an interrupt handler once the TSC passes DEADLINE. */
+struct hrtimer {
+	uint64_t deadline;          /* TSC value at which to fire. */
+	timer_func *func;           /* Called in interrupt context. */
+	void *aux;
+	bool pending;               /* Armed and not yet fired. */
+	struct list_elem elem;      /* Element in the hrtimer list. */
+};
+
+void hrtimer_init (struct hrtimer *, timer_func *, void *aux);
+bool hrtimer_available (void);
+void hrtimer_start (struct hrtimer *, int64_t ns);
+bool hrtimer_cancel (struct hrtimer *);
+
+uint64_t timer_tsc (void);
+int64_t timer_tsc_to_ns (uint64_t cycles);
+int64_t timer_ns (void);
+
+void timer_event_init (struct timer_event *, timer_func *, void *aux);
+void timer_event_add (struct timer_event *, int64_t expires);
+bool timer_event_cancel (struct timer_event *);
+
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
@@ -21,5 +58,8 @@ void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
 void busy_wait(int64_t loops);
 #endif /* devices/timer.h */
@@ -11,6 +11,7 @@ struct file {
 	struct inode *inode;        /* File's inode. */
 	off_t pos;                  /* Current position. */
 	bool deny_write;            /* Has file_deny_write() been called? */
+	int ref_cnt;                /* file_open() plus file_get() calls. */
 };
 
 
@@ -20,6 +21,7 @@ struct inode;
 struct file *file_open (struct inode *);
 struct file *file_reopen (struct file *);
 struct file *file_duplicate (struct file *file);
+struct file *file_get (struct file *);
 void file_close (struct file *);
 struct inode *file_get_inode (struct file *);
 
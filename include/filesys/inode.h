@@ -5,6 +5,7 @@
 #include "filesys/off_t.h"
 #include "devices/disk.h"
 #include <list.h>
+#include "threads/rcu.h"
 #include "threads/synch.h"
 struct bitmap;
 
@@ -28,6 +29,7 @@ struct inode {
 
 	/* synchronization */
 	struct lock inode_lock;
+	struct rcu_head rcu;                /* Frees us after the last close. */
 };
 
 void inode_init (void);
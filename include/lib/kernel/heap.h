@@ -0,0 +1,58 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Pairing heap.
+ *
+ * An intrusive priority queue.  Like the list and hash table, the
+ * heap does no dynamic allocation: each structure that can be in a
+ * heap embeds a struct heap_elem member, and heap_entry converts an
+ * element pointer back into the containing structure.
+ * 삽입과 최솟값 확인은 O(1), 삭제는 amortized O(log n)이다.
+ *
+ * heap_pop() always returns the least element under the heap's
+ * comparison function.  Any element can also be removed, which is
+ * how an element's key is changed: remove it, update the key, and
+ * push it again (heap_update()). */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child;    /* Leftmost child. */
+	struct heap_elem *next;     /* Right sibling. */
+	struct heap_elem *prev;     /* Left sibling, or parent if leftmost. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to the
+ * structure that HEAP_ELEM is embedded inside. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)                   \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child            \
+		- offsetof (STRUCT, MEMBER.child)))
+
+/* Compares the value of two heap elements A and B, given auxiliary
+ * data AUX.  Returns true if A should come out of the heap before
+ * B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+		const struct heap_elem *b, void *aux);
+
+/* Pairing heap. */
+struct heap {
+	struct heap_elem *root;     /* Least element, or NULL if empty. */
+	size_t size;                /* Number of elements. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+
+struct heap_elem *heap_top (const struct heap *);
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
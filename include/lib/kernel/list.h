@@ -130,6 +130,14 @@ struct list_elem *list_remove (struct list_elem *);
 struct list_elem *list_pop_front (struct list *);
 struct list_elem *list_pop_back (struct list *);
 
+/* RCU-safe traversal and update; see list.c. */
+struct list_elem *list_begin_rcu (struct list *);
+struct list_elem *list_next_rcu (struct list_elem *);
+void list_insert_rcu (struct list_elem *, struct list_elem *);
+void list_push_front_rcu (struct list *, struct list_elem *);
+void list_push_back_rcu (struct list *, struct list_elem *);
+void list_remove_rcu (struct list_elem *);
+
 /* List elements. */
 struct list_elem *list_front (struct list *);
 struct list_elem *list_back (struct list *);
@@ -36,6 +36,20 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Instrumentation. */
+	SYS_FAULT_STAT,             /* Reads page fault statistics. */
+	SYS_MINCORE,                /* Reports which pages are resident. */
+	SYS_FRAME_LIMIT,            /* Sets the resident-frame limit. */
+	SYS_LOCKSTAT,               /* Reads lock contention statistics. */
+
+	/* User-level synchronization. */
+	SYS_FUTEX,                  /* Waits on or wakes a futex word. */
+
+	/* User threads. */
+	SYS_UTHREAD_CREATE,         /* Starts a thread in this process. */
+	SYS_UTHREAD_JOIN,           /* Waits for a thread to exit. */
+	SYS_UTHREAD_EXIT,           /* Terminates the calling thread. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,36 @@
+#ifndef __LIB_USER_SYNCH_H
+#define __LIB_USER_SYNCH_H
+
+#include <stdbool.h>
+
+/* User-level mutex and condition variable built on futex().  Neither
+   makes a system call unless a thread actually has to sleep or some
+   thread is sleeping. */
+
+/* Mutex.  STATE is 0 when unlocked, 1 when locked with no waiters,
+   and 2 when locked with possible waiters. */
+struct mutex {
+	int state;
+};
+
+#define MUTEX_INITIALIZER { 0 }
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+/* Condition variable.  SEQ changes on every signal, so a waiter that
+   saw the old value is never put to sleep after missing a signal. */
+struct condvar {
+	int seq;
+};
+
+#define CONDVAR_INITIALIZER { 0 }
+
+void condvar_init (struct condvar *);
+void condvar_wait (struct condvar *, struct mutex *);
+void condvar_signal (struct condvar *);
+void condvar_broadcast (struct condvar *);
+
+#endif /* lib/user/synch.h */
@@ -19,6 +19,40 @@ typedef int off_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* Page fault classes for fault_stat(). */
+#define FAULT_MINOR 0           /* First touch of an anonymous page. */
+#define FAULT_FILE 1            /* Page read in from a file. */
+#define FAULT_SWAP 2            /* Page read back from swap. */
+#define FAULT_STACK 3           /* Stack growth. */
+#define FAULT_INVALID 4         /* Fault that could not be serviced. */
+#define FAULT_HIST_BUCKETS 32
+
+/* Page fault statistics returned by fault_stat().  hist[i] counts the
+   faults that took between 2^i and 2^(i+1) TSC cycles to service. */
+struct fault_stat {
+	unsigned long long count;
+	unsigned long long cycles;
+	unsigned long long max_cycles;
+	unsigned long long hist[FAULT_HIST_BUCKETS];
+};
+
+/* One lock_init() call site's statistics, as returned by lockstat(),
+   summed over every lock initialized there.  Times are in TSC cycles. */
+struct lockstat {
+	char name[32];                  /* lock_init()'s argument. */
+	char site[32];                  /* "file:line" of the call. */
+	char max_holder[16];            /* Thread with the longest hold. */
+	unsigned long long acquired;
+	unsigned long long contended;
+	unsigned long long wait_cycles;
+	unsigned long long max_hold_cycles;
+};
+
+/* Per-page residency reported by mincore(). */
+#define MINCORE_UNTOUCHED 0     /* Never faulted in. */
+#define MINCORE_RESIDENT 1      /* In memory. */
+#define MINCORE_PAGED_OUT 2     /* Evicted to swap or back to its file. */
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
@@ -53,6 +87,24 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+/* Instrumentation. */
+int fault_stat (int kind, struct fault_stat *st);
+int mincore (void *addr, size_t length, unsigned char *vec);
+int frame_limit (int pages);
+int lockstat (struct lockstat *buf, int max);
+
+/* User-level synchronization. */
+#define FUTEX_WAIT 0                /* Sleep if *UADDR == VAL. */
+#define FUTEX_WAKE 1                /* Wake up to VAL sleepers. */
+int futex (int *uaddr, int op, int val);
+
+/* User threads.  A thread runs FUNC (AUX) on its own stack in the
+   caller's address space and exits with FUNC's return value. */
+typedef int uthread_func (void *aux);
+pid_t uthread_create (uthread_func *func, void *aux);
+int uthread_join (pid_t tid);
+void uthread_exit (int status) NO_RETURN;
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
@@ -0,0 +1,22 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Maximum number of CPUs. */
+#define CPU_MAX 8
+
+/* Per-CPU data.  cpus[0] is the boot processor. */
+struct cpu {
+	int id;                     /* Index in cpus[]. */
+	bool sched;                 /* Runs threads. */
+	uint64_t rcu_qs;            /* Last RCU grace period seen quiescent. */
+};
+
+extern struct cpu cpus[CPU_MAX];
+
+struct cpu *cpu_current (void);
+int cpu_id (void);
+
+#endif /* threads/cpu.h */
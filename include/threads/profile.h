@@ -0,0 +1,17 @@
+#ifndef THREADS_PROFILE_H
+#define THREADS_PROFILE_H
+
+#include <stdbool.h>
+#include "threads/interrupt.h"
+
+/* -profile[=HZ]: sample the interrupted instruction pointer from the
+   timer interrupt, every tick or, if HZ is above TIMER_FREQ, HZ times
+   a second. */
+extern bool profile_enabled;
+extern int profile_hz;
+
+void profile_init (void);
+void profile_sample (struct intr_frame *);
+void profile_print (void);
+
+#endif /* threads/profile.h */
@@ -0,0 +1,47 @@
+#ifndef THREADS_RCU_H
+#define THREADS_RCU_H
+
+#include <list.h>
+#include <stdint.h>
+
+/* Read-copy-update.
+
+   Readers of a read-mostly structure bracket their accesses with
+   rcu_read_lock() and rcu_read_unlock(), taking no lock and leaving
+   interrupts on.  A writer unlinks an object, then waits for a grace
+   period, with synchronize_rcu() or call_rcu(), before freeing it: by
+   then every reader that could have seen the object has finished.
+
+   Read-side sections may be preempted but must not sleep. */
+
+struct rcu_head;
+typedef void rcu_func (struct rcu_head *);
+
+/* Embedded in an object to be freed after a grace period. */
+struct rcu_head {
+	struct list_elem elem;      /* Element in the callback list. */
+	rcu_func *func;             /* Called once the grace period ends. */
+	uint64_t gp;                /* Grace period to wait for. */
+};
+
+void rcu_init (void);
+
+void rcu_read_lock (void);
+void rcu_read_unlock (void);
+
+void synchronize_rcu (void);
+void call_rcu (struct rcu_head *, rcu_func *);
+
+/* Loads pointer P for an RCU reader, so that the pointee's contents
+   are read after the pointer. */
+#define rcu_dereference(P) __atomic_load_n (&(P), __ATOMIC_ACQUIRE)
+
+/* Stores V into pointer P, publishing V's contents to RCU readers. */
+#define rcu_assign_pointer(P, V) __atomic_store_n (&(P), (V), __ATOMIC_RELEASE)
+
+/* For thread.c. */
+struct thread;
+void rcu_note_context_switch (struct thread *);
+void rcu_tick (void);
+
+#endif /* threads/rcu.h */
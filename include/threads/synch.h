@@ -1,13 +1,16 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, highest priority first. */
 };
 
 void sema_init(struct semaphore*, unsigned value);
@@ -20,17 +23,83 @@ void sema_self_test(void);
 struct lock {
 	struct thread* holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct list_elem elem;      /* Element in holder's held_locks. */
+#ifdef LOCKSTAT
+	struct lock_stat* stat;     /* Statistics of our lock_init() site. */
+	uint64_t acquired_tsc;      /* TSC when the holder got us. */
+#endif
 };
 
+/* Priority donation is passed along at most this many nested lock
+	 holders by default. */
+#define DONATE_DEPTH_DEFAULT 8
+extern int donate_depth_max;
+
 void lock_init(struct lock*);
 void lock_acquire(struct lock*);
 bool lock_try_acquire(struct lock*);
 void lock_release(struct lock*);
 bool lock_held_by_current_thread(const struct lock*);
 
+#ifdef LOCKSTAT
+/* Contention statistics, kept per call site of lock_init(): all the
+	 locks one line initializes (every malloc descriptor's, every
+	 inode's) add up in one lock_stat.  Times are in TSC cycles.
+	 Build with "make LOCKSTAT=1". */
+struct lock_stat {
+	const char* name;           /* lock_init()'s argument, as written. */
+	const char* file;           /* Site of the lock_init() call. */
+	int line;
+	uint64_t acquired;          /* # of acquisitions. */
+	uint64_t contended;         /* # of them that had to wait. */
+	uint64_t wait_cycles;       /* Total time spent waiting. */
+	uint64_t max_hold_cycles;   /* Longest single hold. */
+	char max_holder[16];        /* Name of the thread that held it. */
+	struct lock_stat* next;     /* Next in the registry. */
+	bool registered;
+};
+
+void lock_init_stat(struct lock*, struct lock_stat*);
+size_t lockstat_top(struct lock_stat** top, size_t max);
+void lockstat_print(size_t max);
+
+#define lock_init(LOCK) ({                                              \
+	static struct lock_stat lock_stat_ = {                          \
+		.name = #LOCK, .file = __FILE__, .line = __LINE__       \
+	};                                                              \
+	lock_init_stat(LOCK, &lock_stat_);                              \
+})
+#endif
+
+/* Reader-writer lock.  Any number of readers or a single writer
+	 may hold it.  A waiting writer keeps new readers out (writer
+	 preference), and waiters donate their priority to every holder. */
+#define RWLOCK_HOLD_MAX 4           /* rwlocks one thread may hold at once. */
+
+/* One thread's hold on an rwlock. */
+struct rwlock_hold {
+	struct rwlock* rwlock;      /* Held rwlock, or NULL if unused. */
+	struct thread* thread;      /* Holding thread. */
+	struct list_elem elem;      /* Element in rwlock->holders. */
+};
+
+struct rwlock {
+	struct thread* writer;      /* Thread holding for writing, or NULL. */
+	unsigned reader_cnt;        /* # of threads holding for reading. */
+	struct list holders;        /* rwlock_holds of all holders. */
+	struct heap read_waiters;   /* Threads waiting to read. */
+	struct heap write_waiters;  /* Threads waiting to write. */
+};
+
+void rwlock_init(struct rwlock*);
+void rwlock_acquire_read(struct rwlock*);
+void rwlock_acquire_write(struct rwlock*);
+void rwlock_release_read(struct rwlock*);
+void rwlock_release_write(struct rwlock*);
+
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, highest priority first. */
 };
 
 void cond_init(struct condition*);
@@ -38,6 +107,29 @@ void cond_wait(struct condition*, struct lock*);
 void cond_signal(struct condition*, struct lock*);
 void cond_broadcast(struct condition*, struct lock*);
 
+/* Wait queue.  Threads sleep on it until a predicate holds; whoever
+	 changes what the predicate reads calls wake_up().  An exclusive
+	 waiter stands for work only one thread can take (a free buffer, a
+	 request to serve), so wake_up() wakes only the first of them,
+	 along with every shared waiter.  wake_up() may be called from an
+	 interrupt handler. */
+struct wait_queue {
+	struct list waiters;        /* wait_queue_entrys, shared ones first. */
+};
+
+/* Returns true once the waiter may go on.  Called with interrupts
+	 off, so it must be quick and must not sleep. */
+typedef bool wait_pred(void* aux);
+
+void wait_queue_init(struct wait_queue*);
+void wait_event(struct wait_queue*, wait_pred*, void* aux);
+void wait_event_exclusive(struct wait_queue*, wait_pred*, void* aux);
+bool wait_event_timeout(struct wait_queue*, wait_pred*, void* aux,
+	bool exclusive, int64_t ticks);
+int wake_up(struct wait_queue*);
+int wake_up_all(struct wait_queue*);
+void wait_event_kick(struct thread*);
+
 void refresh_priority(void);
 
 /* Optimization barrier.
@@ -3,8 +3,10 @@
 #include "threads/synch.h"
 #include <debug.h>
 #include <list.h>
+#include <rbtree.h>
 #include <stdint.h>
 #include "threads/interrupt.h"
+#include "threads/fixed-point.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -31,6 +33,11 @@ typedef int tid_t;
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX 63     /* Highest priority. */
 
+/* Thread nice values. */
+#define NICE_MIN -20   /* Nicest. */
+#define NICE_DEFAULT 0 /* Default nice. */
+#define NICE_MAX 19    /* Least nice. */
+
 /* A kernel thread or user process.
  *
  * Each thread structure is stored in its own 4 kB page.  The
@@ -95,11 +102,23 @@ struct child_status {
     bool has_exited;      
     bool wait_called;     
 	bool fork_success;
-    struct semaphore sema_wait;  
-	struct semaphore sema_fork;
+	bool fork_done;               /* Child finished (or failed) fork. */
+	struct wait_queue wq;         /* Parent waits for fork_done, has_exited. */
     struct list_elem elem;       
 };
 
+/* A user thread's exit status, kept in its process leader's
+   uthread_list until the thread is joined or the process exits. */
+struct uthread_status {
+	tid_t tid;
+	int exit_status;
+	bool has_exited;
+	bool join_called;
+	struct thread *thread;          /* The thread, while it runs user code. */
+	struct wait_queue wq;           /* Joiner waits for has_exited. */
+	struct list_elem elem;          /* Element in leader's uthread_list. */
+};
+
 /* file descriptor */
 struct fd_table{
 	struct file* fd_entries[FD_MAX];
@@ -124,18 +143,39 @@ struct thread {
 	char name[16];                      /* Name (for debugging purposes). */
 	int priority;                       /* Priority. */
 
-	/* timer를 위하여 선언*/
-	int64_t wakeup_tick;
-
 	/* donation을 위하여 선언 */
 	int original_priority;
 	struct lock* wait_on_lock;
-	struct list donations;
-	struct list_elem donation_elem;
+	struct list held_locks;             /* Locks held, each donating its top waiter. */
+
+	/* mlfqs를 위하여 선언 */
+	int nice;
+	fixed_t recent_cpu;
+	struct list_elem all_elem;          /* Element in all_list. */
+
+	/* cfs를 위하여 선언 */
+	uint64_t vruntime;                  /* Weighted run time, in ns. */
+	uint64_t exec_start;                /* TSC when last charged. */
+	struct rb_node cfs_node;            /* Node in the CFS run queue. */
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem; /* List element. */
 
+	/* semaphore, rwlock 대기열(heap)을 위하여 선언 */
+	struct heap_elem wait_elem;         /* Element in wait_queue. */
+	struct heap* wait_queue;            /* Waiter heap we are blocked in. */
+	struct wait_queue_entry* wait_entry; /* Our entry while in wait_event(). */
+	uint64_t wait_seq;                  /* FIFO order among equal priority. */
+
+	/* rcu를 위하여 선언 */
+	int rcu_nesting;                    /* Depth of rcu_read_lock(). */
+	bool rcu_blocked;                   /* Preempted inside a reader. */
+	uint64_t rcu_gp;                    /* If blocked: see threads/rcu.c. */
+	struct list_elem rcu_elem;          /* If blocked: blocked_readers. */
+
+	/* rwlock을 위하여 선언 */
+	struct rwlock_hold rw_holds[RWLOCK_HOLD_MAX];
+
 	/* 내가 포크된 프로세스라면 child_status를 가지고 있다. */
 	bool isforked;
 	struct child_status *child_status;
@@ -157,6 +197,18 @@ struct thread {
 
 	void *rsp;
 
+	/* 유저 스레드를 위하여 선언.  같은 프로세스의 스레드는 leader의
+	   pml4, spt, fd_table, mmap_table을 함께 쓴다. */
+	struct thread *leader;              /* Initial thread of our process. */
+	struct uthread_status *uthread_status; /* Non-leaders only. */
+	int uthread_slot;                   /* Non-leaders only: stack slot. */
+	struct list uthread_list;           /* Leader only: uthread_status list. */
+	int uthread_cnt;                    /* Leader only: live non-leaders. */
+	uint32_t uthread_slots;             /* Leader only: stack slots in use. */
+	struct semaphore uthread_sema;      /* Leader only: upped per exit. */
+	bool group_exiting;                 /* Leader only: process is exiting. */
+	int group_exit_status;              /* Leader only: its exit status. */
+
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t* pml4;                     /* Page map level 4 */
@@ -168,6 +220,7 @@ struct thread {
 
 	/* Owned by thread.c. */
 	struct intr_frame tf; /* Information for switching */
+	uint64_t ctx_rsp;     /* Saved stack pointer; see switch.S. */
 	unsigned magic;       /* Detects stack overflow. */
 };
 
@@ -176,6 +229,11 @@ struct thread {
 	 Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the completely fair scheduler, which shares the CPU in
+	 proportion to weights derived from priority and nice.
+	 Controlled by kernel command-line option "-cfs". */
+extern bool thread_cfs;
+
 void thread_init(void);
 void thread_start(void);
 
@@ -205,10 +263,8 @@ int thread_get_load_avg(void);
 
 void do_iret(struct intr_frame* tf);
 
-bool earlier_wake_up(const struct list_elem* a, const struct list_elem* b, void* aux);
-
-bool thread_compare_priority(const struct list_elem* a, const struct list_elem* b,
-	void* aux UNUSED);
 void thread_test_preemption(void);
+bool thread_should_preempt(struct thread* t);
+void thread_set_effective_priority(struct thread* t, int priority);
 
 #endif /* threads/thread.h */
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Static tracepoints.
+
+   trace (EVENT, A0, A1) appends a binary record (TSC, EVENT, A0, A1)
+   to the running CPU's ring buffer.  It takes no lock and is safe in
+   interrupt handlers and in the scheduler, and costs one test of
+   trace_enabled unless the kernel was started with -trace.  The rings
+   are dumped at power off; utils/pintos-trace turns the dump into a
+   timeline. */
+
+/* Events, with the meaning of their two arguments. */
+enum trace_event {
+	TRACE_THREAD_NEW,           /* tid, first 8 bytes of name. */
+	TRACE_SWITCH,               /* tid switched from, tid switched to. */
+	TRACE_WAKEUP,               /* tid woken, its priority. */
+	TRACE_PAGE_FAULT,           /* fault address, error code. */
+	TRACE_SWAP_IN,              /* page address, first swap sector. */
+	TRACE_SWAP_OUT,             /* page address, first swap sector. */
+	TRACE_DISK_ISSUE,           /* sector, disk * 2 + is_write. */
+	TRACE_DISK_DONE,            /* channel, 0. */
+	TRACE_SYSCALL_ENTER,        /* syscall number, tid. */
+	TRACE_SYSCALL_EXIT,         /* syscall number, return value. */
+	TRACE_EVENT_CNT
+};
+
+/* -trace: records events from boot on. */
+extern bool trace_option;
+extern bool trace_enabled;
+
+#define trace(EVENT, A0, A1)                                            \
+	do {                                                            \
+		if (trace_enabled)                                      \
+			trace_emit (EVENT, (uint64_t) (A0), (uint64_t) (A1)); \
+	} while (0)
+
+void trace_init (void);
+void trace_emit (enum trace_event, uint64_t a0, uint64_t a1);
+void trace_print (void);
+
+#endif /* threads/trace.h */
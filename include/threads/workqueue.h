@@ -0,0 +1,66 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "devices/timer.h"
+#include "threads/synch.h"
+
+/* Deferred work.
+
+   An interrupt handler that has more to do than it should with
+   interrupts off queues a work item instead.  A workqueue's worker
+   thread later calls the item's FUNC (AUX) in thread context, where it
+   may sleep, take locks and run with interrupts on.
+
+   The only user so far is RCU, whose timer-tick hook queues the
+   grace-period callbacks.  No device interrupt handler defers to a
+   workqueue: the disk, serial and keyboard handlers only ack the
+   device and wake a waiter or queue a byte, which is cheaper than
+   waking a worker, and the timer callbacks wake sleepers and end time
+   slices, which must happen on time in the interrupt. */
+
+typedef void work_func (void *aux);
+
+/* A unit of deferred work. */
+struct work {
+	work_func *func;            /* Called in the worker thread. */
+	void *aux;
+	bool pending;               /* Queued and not yet started. */
+	struct list_elem elem;      /* Element in a workqueue's items. */
+};
+
+/* Work that is queued once a number of timer ticks have passed, so
+   that the timer callback itself stays short. */
+struct delayed_work {
+	struct work work;
+	struct workqueue *wq;       /* Queue to put WORK on. */
+	struct timer_event timer;
+};
+
+/* A list of pending work and the kernel thread that runs it. */
+struct workqueue {
+	char name[16];              /* Also the worker thread's name. */
+	struct list items;          /* Pending works, oldest first. */
+	struct semaphore ready;     /* Upped once per queued work. */
+};
+
+/* Shared queue for work with no need of its own worker. */
+extern struct workqueue *system_wq;
+
+void workqueue_init (void);
+struct workqueue *workqueue_create (const char *name, int priority);
+
+void work_init (struct work *, work_func *, void *aux);
+bool queue_work (struct workqueue *, struct work *);
+bool schedule_work (struct work *);
+bool cancel_work (struct work *);
+void flush_workqueue (struct workqueue *);
+
+void delayed_work_init (struct delayed_work *, work_func *, void *aux);
+bool queue_delayed_work (struct workqueue *, struct delayed_work *,
+		int64_t ticks);
+bool cancel_delayed_work (struct delayed_work *);
+
+#endif /* threads/workqueue.h */
@@ -9,6 +9,11 @@ int process_exec (void *f_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (struct thread *next);
+tid_t process_thread_create (void *entry, void *func, void *aux);
+int process_thread_join (tid_t tid);
+void process_thread_exit (int status) NO_RETURN;
+void process_exit_threads (int status);
+void process_group_exit (int status);
 bool lazy_load_segment (struct page *page, void *aux);
 bool lazy_load_segment_mmap (struct page *page, void *aux);
 
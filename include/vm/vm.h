@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include "threads/palloc.h"
 #include "include/lib/kernel/hash.h"
+#include "threads/synch.h"
 
 enum vm_type {
 	/* page not initialized */
@@ -74,7 +75,12 @@ struct page {
 struct frame {
 	void *kva;
 	struct page *page;
+	struct thread *owner;   /* Process whose address space maps PAGE. */
 	struct list_elem elem;
+	bool pinned;            /* Never chosen as an eviction victim. */
+	bool evicting;          /* Being written out; cannot be pinned. */
+	bool clock_ref;         /* Accessed since the clock hand last passed. */
+	bool ws_ref;            /* Accessed since the last working set sample. */
 };
 
 /* The function table for page operations.
@@ -99,6 +105,45 @@ struct page_operations {
 struct supplemental_page_table {
 	/* hash table */
 	struct hash spt_table;
+
+	/* Held while spt_table changes or a fault in it is serviced, since
+	 * the threads of a process share one table.  Taken after
+	 * syscall_lock, never before it. */
+	struct lock lock;
+
+	/* Memory accounting, maintained by vm.c. */
+	size_t resident_cnt;    /* Frames currently mapped. */
+	size_t frame_limit;     /* Soft resident-frame limit, 0 if none. */
+	size_t wss;             /* Working set size estimate, in pages. */
+	size_t ws_sample;       /* Accessed frames seen by the current sample. */
+
+	struct thread *owner;   /* Thread this table is embedded in. */
+};
+
+/* Default soft resident-frame limit for new processes, 0 if none. */
+extern size_t vm_frame_limit;
+
+/* Page fault classes, as recorded by vm_try_handle_fault ().
+ * Keep in sync with FAULT_* in lib/user/syscall.h. */
+enum vm_fault_type {
+	VM_FAULT_MINOR,         /* First touch of an anonymous page. */
+	VM_FAULT_FILE,          /* Page read in from a file. */
+	VM_FAULT_SWAP,          /* Anonymous page read back from swap. */
+	VM_FAULT_STACK,         /* Stack growth. */
+	VM_FAULT_INVALID,       /* Fault that was not handled. */
+	VM_FAULT_TYPE_CNT
+};
+
+/* Latency histogram buckets: bucket N counts faults that took
+ * [2^N, 2^(N+1)) TSC cycles. */
+#define VM_FAULT_HIST_BUCKETS 32
+
+/* Counters for one class of page fault. */
+struct vm_fault_stat {
+	uint64_t count;                         /* Number of faults. */
+	uint64_t cycles;                        /* Total TSC cycles spent. */
+	uint64_t max_cycles;                    /* Slowest fault. */
+	uint64_t hist[VM_FAULT_HIST_BUCKETS];   /* Latency histogram. */
 };
 
 #include "threads/thread.h"
@@ -114,6 +159,12 @@ void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 void vm_init (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
+void vm_get_fault_stat (enum vm_fault_type, struct vm_fault_stat *);
+void vm_frame_free (struct frame *frame, bool free_kva);
+void vm_wait_eviction (struct page *page);
+bool vm_pin_user_range (const void *uaddr, size_t size, bool write);
+void vm_unpin_user_range (const void *uaddr, size_t size);
+void vm_print_fault_stats (void);
 
 #define vm_alloc_page(type, upage, writable) \
 	vm_alloc_page_with_initializer ((type), (upage), (writable), NULL, NULL)
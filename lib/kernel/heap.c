@@ -0,0 +1,153 @@
+/* Pairing heap.
+
+   See heap.h for basic information.  This is the two-pass pairing
+   heap of Fredman, Sedgewick, Sleator and Tarjan, "The pairing heap:
+   A new form of self-adjusting heap" (1986).  Each node's children
+   form a doubly linked list through `next' and `prev', with the
+   leftmost child's `prev' pointing at the parent so that any node
+   can be unlinked in O(1). */
+
+#include "heap.h"
+#include "../debug.h"
+
+static struct heap_elem *meld (struct heap *, struct heap_elem *,
+		struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+
+/* Initializes H as an empty heap ordered by LESS, given auxiliary
+   data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->size = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts E into H. */
+void
+heap_push (struct heap *h, struct heap_elem *e) {
+	ASSERT (e != NULL);
+
+	e->child = e->next = e->prev = NULL;
+	h->root = meld (h, h->root, e);
+	h->size++;
+}
+
+/* Removes and returns the least element of H, which must not be
+   empty. */
+struct heap_elem *
+heap_pop (struct heap *h) {
+	struct heap_elem *top = h->root;
+
+	ASSERT (top != NULL);
+
+	h->root = merge_pairs (h, top->child);
+	h->size--;
+	return top;
+}
+
+/* Removes E, which must be in H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	if (e == h->root) {
+		heap_pop (h);
+		return;
+	}
+
+	/* Unlink E and its subtree from its parent's child list, then
+	   fold E's children back into the heap. */
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+
+	h->root = meld (h, h->root, merge_pairs (h, e->child));
+	h->size--;
+}
+
+/* Moves E, which must be in H, to its correct position after its
+   key has changed. */
+void
+heap_update (struct heap *h, struct heap_elem *e) {
+	heap_remove (h, e);
+	heap_push (h, e);
+}
+
+/* Returns the least element of H, or NULL if H is empty. */
+struct heap_elem *
+heap_top (const struct heap *h) {
+	return h->root;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h) {
+	return h->size;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool
+heap_empty (const struct heap *h) {
+	return h->root == NULL;
+}
+
+/* Links roots A and B, either of which may be null, and returns the
+   root of the result.  The larger root becomes the leftmost child of
+   the smaller.  Ties keep A on top. */
+static struct heap_elem *
+meld (struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (h->less (b, a, h->aux)) {
+		struct heap_elem *tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Combines the sibling list starting at FIRST into a single tree and
+   returns its root, or NULL if FIRST is null.  Siblings are melded in
+   pairs left to right, then the pairs are melded right to left. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *result = NULL;
+
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+		struct heap_elem *m;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL)
+			b->next = b->prev = NULL;
+		m = meld (h, a, b);
+		m->next = pairs;
+		pairs = m;
+	}
+
+	while (pairs != NULL) {
+		struct heap_elem *m = pairs;
+
+		pairs = m->next;
+		m->next = NULL;
+		result = meld (h, result, m);
+	}
+	return result;
+}
@@ -204,6 +204,66 @@ list_push_back (struct list *list, struct list_elem *elem) {
 	list_insert (list_end (list), elem);
 }
 
+/* RCU variants.
+
+   Readers walk a list with list_begin_rcu() and list_next_rcu()
+   between rcu_read_lock() and rcu_read_unlock(), with no lock and
+   interrupts on.  Writers still exclude each other, with a lock of
+   their own, and use the functions below.  An element is linked in
+   only once it is fully initialized, and an unlinked element keeps
+   its `next', so that a reader standing on it can still finish the
+   walk; it may be freed only after a grace period (see
+   threads/rcu.c). */
+
+/* Returns the beginning of LIST, for an RCU reader. */
+struct list_elem *
+list_begin_rcu (struct list *list) {
+	ASSERT (list != NULL);
+	return __atomic_load_n (&list->head.next, __ATOMIC_ACQUIRE);
+}
+
+/* Returns the element after ELEM, for an RCU reader. */
+struct list_elem *
+list_next_rcu (struct list_elem *elem) {
+	ASSERT (is_head (elem) || is_interior (elem));
+	return __atomic_load_n (&elem->next, __ATOMIC_ACQUIRE);
+}
+
+/* Inserts ELEM just before BEFORE, publishing it to RCU readers
+   only after its own links are set. */
+void
+list_insert_rcu (struct list_elem *before, struct list_elem *elem) {
+	ASSERT (is_interior (before) || is_tail (before));
+	ASSERT (elem != NULL);
+
+	elem->prev = before->prev;
+	elem->next = before;
+	__atomic_store_n (&before->prev->next, elem, __ATOMIC_RELEASE);
+	before->prev = elem;
+}
+
+/* Inserts ELEM at the beginning of LIST, for RCU readers. */
+void
+list_push_front_rcu (struct list *list, struct list_elem *elem) {
+	list_insert_rcu (list_begin (list), elem);
+}
+
+/* Inserts ELEM at the end of LIST, for RCU readers. */
+void
+list_push_back_rcu (struct list *list, struct list_elem *elem) {
+	list_insert_rcu (list_end (list), elem);
+}
+
+/* Unlinks ELEM from its list.  ELEM's `next' is left alone, since
+   readers may still be on it; don't reuse or free ELEM until a grace
+   period has passed. */
+void
+list_remove_rcu (struct list_elem *elem) {
+	ASSERT (is_interior (elem));
+	__atomic_store_n (&elem->prev->next, elem->next, __ATOMIC_RELAXED);
+	elem->next->prev = elem->prev;
+}
+
 /* Removes ELEM from its list and returns the element that
    followed it.  Undefined behavior if ELEM is not in a list.
 
@@ -0,0 +1,300 @@
+/* Red-black tree.
+
+   See rbtree.h for basic information.  The algorithms follow
+   Cormen et al., "Introduction to Algorithms", chapter 13, with
+   null pointers standing in for the black sentinel leaves. */
+
+#include "rbtree.h"
+#include "../debug.h"
+
+static bool is_red (const struct rb_node *);
+static void replace_child (struct rb_tree *, struct rb_node *old,
+		struct rb_node *new);
+static void rotate_left (struct rb_tree *, struct rb_node *);
+static void rotate_right (struct rb_tree *, struct rb_node *);
+static void insert_fixup (struct rb_tree *, struct rb_node *);
+static void remove_fixup (struct rb_tree *, struct rb_node *,
+		struct rb_node *parent);
+
+/* Initializes T as an empty tree ordered by LESS, given auxiliary
+   data AUX. */
+void
+rb_init (struct rb_tree *t, rb_less_func *less, void *aux) {
+	ASSERT (t != NULL);
+	ASSERT (less != NULL);
+
+	t->root = NULL;
+	t->min = NULL;
+	t->size = 0;
+	t->less = less;
+	t->aux = aux;
+}
+
+/* Inserts N into T.  N is placed after every node that compares
+   equal to it. */
+void
+rb_insert (struct rb_tree *t, struct rb_node *n) {
+	struct rb_node **link = &t->root;
+	struct rb_node *parent = NULL;
+	bool leftmost = true;
+
+	ASSERT (n != NULL);
+
+	while (*link != NULL) {
+		parent = *link;
+		if (t->less (n, parent, t->aux))
+			link = &parent->left;
+		else {
+			link = &parent->right;
+			leftmost = false;
+		}
+	}
+
+	n->parent = parent;
+	n->left = n->right = NULL;
+	n->red = true;
+	*link = n;
+
+	if (leftmost)
+		t->min = n;
+	t->size++;
+	insert_fixup (t, n);
+}
+
+/* Removes N, which must be in T. */
+void
+rb_remove (struct rb_tree *t, struct rb_node *n) {
+	struct rb_node *y = n;
+	struct rb_node *x, *x_parent;
+	bool removed_red = n->red;
+
+	ASSERT (t->size > 0);
+
+	if (t->min == n)
+		t->min = rb_next (n);
+
+	if (n->left == NULL || n->right == NULL) {
+		/* At most one child: splice N out directly. */
+		x = n->left != NULL ? n->left : n->right;
+		x_parent = n->parent;
+		replace_child (t, n, x);
+		if (x != NULL)
+			x->parent = n->parent;
+	} else {
+		/* Two children: move N's successor Y into N's place. */
+		y = n->right;
+		while (y->left != NULL)
+			y = y->left;
+		removed_red = y->red;
+		x = y->right;
+
+		if (y->parent == n)
+			x_parent = y;
+		else {
+			x_parent = y->parent;
+			replace_child (t, y, x);
+			if (x != NULL)
+				x->parent = y->parent;
+			y->right = n->right;
+			y->right->parent = y;
+		}
+
+		replace_child (t, n, y);
+		y->parent = n->parent;
+		y->left = n->left;
+		y->left->parent = y;
+		y->red = n->red;
+	}
+
+	if (!removed_red)
+		remove_fixup (t, x, x_parent);
+	t->size--;
+}
+
+/* Returns the smallest node in T, or NULL if T is empty. */
+struct rb_node *
+rb_min (const struct rb_tree *t) {
+	return t->min;
+}
+
+/* Returns the in-order successor of N, or NULL if N is the
+   largest node in its tree. */
+struct rb_node *
+rb_next (const struct rb_node *n) {
+	if (n->right != NULL) {
+		n = n->right;
+		while (n->left != NULL)
+			n = n->left;
+		return (struct rb_node *) n;
+	}
+
+	while (n->parent != NULL && n == n->parent->right)
+		n = n->parent;
+	return n->parent;
+}
+
+/* Returns the number of nodes in T. */
+size_t
+rb_size (const struct rb_tree *t) {
+	return t->size;
+}
+
+/* Returns true if T is empty, false otherwise. */
+bool
+rb_empty (const struct rb_tree *t) {
+	return t->root == NULL;
+}
+
+/* Null leaves count as black. */
+static bool
+is_red (const struct rb_node *n) {
+	return n != NULL && n->red;
+}
+
+/* Makes NEW take OLD's place as a child of OLD's parent (or as the
+   root).  Does not update NEW's parent pointer. */
+static void
+replace_child (struct rb_tree *t, struct rb_node *old, struct rb_node *new) {
+	if (old->parent == NULL)
+		t->root = new;
+	else if (old == old->parent->left)
+		old->parent->left = new;
+	else
+		old->parent->right = new;
+}
+
+static void
+rotate_left (struct rb_tree *t, struct rb_node *x) {
+	struct rb_node *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	replace_child (t, x, y);
+	y->parent = x->parent;
+	y->left = x;
+	x->parent = y;
+}
+
+static void
+rotate_right (struct rb_tree *t, struct rb_node *x) {
+	struct rb_node *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	replace_child (t, x, y);
+	y->parent = x->parent;
+	y->right = x;
+	x->parent = y;
+}
+
+/* Restores the red-black properties after inserting red node N. */
+static void
+insert_fixup (struct rb_tree *t, struct rb_node *n) {
+	struct rb_node *p;
+
+	while ((p = n->parent) != NULL && p->red) {
+		/* P is red, so it is not the root and has a parent. */
+		struct rb_node *g = p->parent;
+
+		if (p == g->left) {
+			struct rb_node *u = g->right;
+			if (is_red (u)) {
+				p->red = u->red = false;
+				g->red = true;
+				n = g;
+			} else {
+				if (n == p->right) {
+					n = p;
+					rotate_left (t, n);
+					p = n->parent;
+				}
+				p->red = false;
+				g->red = true;
+				rotate_right (t, g);
+			}
+		} else {
+			struct rb_node *u = g->left;
+			if (is_red (u)) {
+				p->red = u->red = false;
+				g->red = true;
+				n = g;
+			} else {
+				if (n == p->left) {
+					n = p;
+					rotate_right (t, n);
+					p = n->parent;
+				}
+				p->red = false;
+				g->red = true;
+				rotate_left (t, g);
+			}
+		}
+	}
+	t->root->red = false;
+}
+
+/* Restores the red-black properties after a black node was
+   removed from above X, whose parent is now PARENT.  X may be
+   null. */
+static void
+remove_fixup (struct rb_tree *t, struct rb_node *x, struct rb_node *parent) {
+	while (x != t->root && !is_red (x)) {
+		/* X is "doubly black", so its sibling W has at least one
+		   real black node below it and cannot be null. */
+		if (x == parent->left) {
+			struct rb_node *w = parent->right;
+			if (w->red) {
+				w->red = false;
+				parent->red = true;
+				rotate_left (t, parent);
+				w = parent->right;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->right)) {
+					w->left->red = false;
+					w->red = true;
+					rotate_right (t, w);
+					w = parent->right;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->right->red = false;
+				rotate_left (t, parent);
+				x = t->root;
+			}
+		} else {
+			struct rb_node *w = parent->left;
+			if (w->red) {
+				w->red = false;
+				parent->red = true;
+				rotate_right (t, parent);
+				w = parent->left;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->left)) {
+					w->right->red = false;
+					w->red = true;
+					rotate_left (t, w);
+					w = parent->left;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->left->red = false;
+				rotate_right (t, parent);
+				x = t->root;
+			}
+		}
+	}
+	if (x != NULL)
+		x->red = false;
+}
@@ -0,0 +1,88 @@
+#include <synch.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <syscall.h>
+
+/* The mutex follows "mutex2" of Ulrich Drepper, "Futexes Are Tricky"
+   (2011): the lock word records whether anyone may be sleeping, so an
+   unlock only enters the kernel when it has to. */
+
+static int
+cmpxchg (int *p, int old, int new) {
+	__atomic_compare_exchange_n (p, &old, new, false,
+			__ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+	return old;
+}
+
+static int
+xchg (int *p, int new) {
+	return __atomic_exchange_n (p, new, __ATOMIC_ACQUIRE);
+}
+
+void
+mutex_init (struct mutex *m) {
+	m->state = 0;
+}
+
+void
+mutex_lock (struct mutex *m) {
+	int c = cmpxchg (&m->state, 0, 1);
+
+	if (c == 0)
+		return;
+
+	/* Contended: mark the lock as having waiters, then sleep until we
+	   are the one to flip it from unlocked. */
+	if (c != 2)
+		c = xchg (&m->state, 2);
+	while (c != 0) {
+		futex (&m->state, FUTEX_WAIT, 2);
+		c = xchg (&m->state, 2);
+	}
+}
+
+bool
+mutex_trylock (struct mutex *m) {
+	return cmpxchg (&m->state, 0, 1) == 0;
+}
+
+void
+mutex_unlock (struct mutex *m) {
+	if (__atomic_fetch_sub (&m->state, 1, __ATOMIC_RELEASE) != 1) {
+		__atomic_store_n (&m->state, 0, __ATOMIC_RELEASE);
+		futex (&m->state, FUTEX_WAKE, 1);
+	}
+}
+
+void
+condvar_init (struct condvar *cv) {
+	cv->seq = 0;
+}
+
+/* Atomically releases M and waits for CV to be signaled, then
+   reacquires M.  As with the kernel's condition variables, the caller
+   must recheck its condition after waking. */
+void
+condvar_wait (struct condvar *cv, struct mutex *m) {
+	int seq = __atomic_load_n (&cv->seq, __ATOMIC_ACQUIRE);
+
+	mutex_unlock (m);
+	futex (&cv->seq, FUTEX_WAIT, seq);
+
+	/* Others may have been woken with us, so take M in the contended
+	   state to make sure our unlock wakes the next one. */
+	while (xchg (&m->state, 2) != 0)
+		futex (&m->state, FUTEX_WAIT, 2);
+}
+
+void
+condvar_signal (struct condvar *cv) {
+	__atomic_fetch_add (&cv->seq, 1, __ATOMIC_RELEASE);
+	futex (&cv->seq, FUTEX_WAKE, 1);
+}
+
+void
+condvar_broadcast (struct condvar *cv) {
+	__atomic_fetch_add (&cv->seq, 1, __ATOMIC_RELEASE);
+	futex (&cv->seq, FUTEX_WAKE, INT_MAX);
+}
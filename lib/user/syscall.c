@@ -194,3 +194,51 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+int
+fault_stat (int kind, struct fault_stat *st) {
+	return syscall2 (SYS_FAULT_STAT, kind, st);
+}
+
+int
+mincore (void *addr, size_t length, unsigned char *vec) {
+	return syscall3 (SYS_MINCORE, addr, length, vec);
+}
+
+int
+frame_limit (int pages) {
+	return syscall1 (SYS_FRAME_LIMIT, pages);
+}
+
+int
+lockstat (struct lockstat *buf, int max) {
+	return syscall2 (SYS_LOCKSTAT, buf, max);
+}
+
+int
+futex (int *uaddr, int op, int val) {
+	return syscall3 (SYS_FUTEX, uaddr, op, val);
+}
+
+/* First code a new thread runs: calls FUNC (AUX) and exits with its
+   return value. */
+static void
+uthread_start (uthread_func *func, void *aux) {
+	uthread_exit (func (aux));
+}
+
+pid_t
+uthread_create (uthread_func *func, void *aux) {
+	return (pid_t) syscall3 (SYS_UTHREAD_CREATE, uthread_start, func, aux);
+}
+
+int
+uthread_join (pid_t tid) {
+	return syscall1 (SYS_UTHREAD_JOIN, tid);
+}
+
+void
+uthread_exit (int status) {
+	syscall1 (SYS_UTHREAD_EXIT, status);
+	NOT_REACHED ();
+}
@@ -0,0 +1,50 @@
+/* Checks that timer_usleep() blocks on a high-resolution timer
+   instead of spinning: a lower-priority thread must get to run while
+   the main thread sleeps, and each sleep must last at least as long
+   as requested. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEP_US 2000
+#define ITERATIONS 5
+
+static volatile int counter;
+static volatile bool done;
+
+static void
+spinner (void *aux UNUSED) 
+{
+  while (!done)
+    counter++;
+}
+
+void
+test_alarm_usleep (void) 
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  thread_create ("spinner", PRI_DEFAULT - 1, spinner, NULL);
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      int before = counter;
+      int64_t start = timer_ns ();
+      int64_t elapsed;
+
+      timer_usleep (SLEEP_US);
+      elapsed = timer_ns () - start;
+      if (elapsed < SLEEP_US * 1000)
+        fail ("slept %lld ns, expected at least %d us", elapsed, SLEEP_US);
+      if (counter == before)
+        fail ("lower-priority thread did not run during sleep %d", i);
+    }
+  done = true;
+  pass ();
+}
@@ -0,0 +1,80 @@
+/* Measures how evenly the completely fair scheduler shares the CPU.
+
+   Four threads spin for 10 seconds, counting loop iterations.  Three
+   run at PRI_DEFAULT (nice 0, weight 1024) and one at PRI_DEFAULT + 8
+   (nice -5, weight 3121), so they should receive about 16.5%, 16.5%,
+   16.5% and 50.4% of the iterations, respectively.  Under strict
+   priority the last thread would get everything. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 4
+
+struct thread_info 
+  {
+    int64_t start_time;
+    int64_t iterations;
+    struct semaphore *done;
+  };
+
+static void load_thread (void *aux);
+
+void
+test_cfs_fair (void) 
+{
+  static const int priorities[THREAD_CNT] =
+    {PRI_DEFAULT, PRI_DEFAULT, PRI_DEFAULT, PRI_DEFAULT + 8};
+  struct thread_info info[THREAD_CNT];
+  struct semaphore done;
+  int64_t start_time, total = 0;
+  int i;
+
+  ASSERT (thread_cfs);
+
+  sema_init (&done, 0);
+  start_time = timer_ticks ();
+  msg ("Starting %d threads...", THREAD_CNT);
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      struct thread_info *ti = &info[i];
+      char name[16];
+
+      ti->start_time = start_time;
+      ti->iterations = 0;
+      ti->done = &done;
+
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, priorities[i], load_thread, ti);
+    }
+
+  msg ("Sleeping 12 seconds to let threads run, please wait...");
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    total += info[i].iterations;
+  for (i = 0; i < THREAD_CNT; i++)
+    msg ("Thread %d received %"PRId64"%% of the CPU.",
+         i, info[i].iterations * 100 / total);
+}
+
+static void
+load_thread (void *ti_) 
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 2 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + 10 * TIMER_FREQ;
+
+  /* Start and stop together, so every thread competes for the whole
+     measurement. */
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time) 
+    ti->iterations++;
+  sema_up (ti->done);
+}
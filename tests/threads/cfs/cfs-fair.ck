@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::mlfqs;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+my (@actual);
+foreach (@output) {
+    my ($id, $share) = /Thread (\d+) received (\d+)% of the CPU\./ or next;
+    $actual[$id] = $share;
+}
+
+# Shares by weight: 1024, 1024, 1024 and 3121 out of 6193.
+my (@expected) = (16.5, 16.5, 16.5, 50.4);
+mlfqs_compare ("thread", "%d", \@actual, \@expected, 5, [0, 3, 1],
+	       "Some CPU shares were missing or differed from those "
+	       . "expected by more than 5%.");
+pass;
@@ -0,0 +1,74 @@
+/* Measures wakeup latency under the completely fair scheduler.
+
+   Three threads at the main thread's priority spin while the main
+   thread repeatedly sleeps for 2 ms.  A woken sleeper has run less
+   than the spinners, so it should preempt them immediately instead of
+   waiting for the end of a time slice.  Reports how long each wakeup
+   overshot the requested sleep. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define HOG_CNT 3
+#define SLEEP_US 2000
+#define ITERATIONS 50
+
+static volatile bool done;
+
+static void
+hog_thread (void *done_) 
+{
+  struct semaphore *hog_done = done_;
+
+  while (!done)
+    continue;
+  sema_up (hog_done);
+}
+
+void
+test_cfs_wakeup (void) 
+{
+  struct semaphore hog_done;
+  int64_t total = 0, max = 0;
+  int i;
+
+  ASSERT (thread_cfs);
+
+  sema_init (&hog_done, 0);
+  done = false;
+  for (i = 0; i < HOG_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "hog %d", i);
+      thread_create (name, PRI_DEFAULT, hog_thread, &hog_done);
+    }
+
+  /* Let the hogs build up some run time first. */
+  timer_msleep (100);
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      int64_t start = timer_ns ();
+      int64_t late;
+
+      timer_usleep (SLEEP_US);
+      late = timer_ns () - start - SLEEP_US * 1000;
+      if (late < 0)
+        fail ("woke up %"PRId64" ns early", -late);
+      total += late;
+      if (late > max)
+        max = late;
+    }
+
+  done = true;
+  for (i = 0; i < HOG_CNT; i++)
+    sema_down (&hog_done);
+
+  msg ("Average wakeup latency: %"PRId64" us.", total / ITERATIONS / 1000);
+  msg ("Maximum wakeup latency: %"PRId64" us.", max / 1000);
+}
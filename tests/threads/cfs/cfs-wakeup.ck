@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+my ($avg, $max);
+foreach (@output) {
+    $avg = $1 if /Average wakeup latency: (\d+) us\./;
+    $max = $1 if /Maximum wakeup latency: (\d+) us\./;
+}
+fail "missing wakeup latency report\n" if !defined $avg || !defined $max;
+
+# A strict-priority scheduler would leave the sleeper waiting behind
+# the spinners for most of a 40 ms time slice.
+fail "average wakeup latency $avg us exceeds 2000 us\n" if $avg > 2000;
+pass;
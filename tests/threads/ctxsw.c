@@ -0,0 +1,57 @@
+/* Measures the cost of a thread switch.
+
+   The main thread and a partner of the same priority hand a
+   semaphore back and forth, so that every sema_down() blocks and
+   every sema_up() wakes the other thread: each round trip is two
+   switches.  Reports the average number of TSC cycles per switch,
+   including the semaphore operations around it. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define ROUND_CNT 10000
+
+static struct semaphore ping, pong;
+
+static void
+partner (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++) 
+    {
+      sema_down (&ping);
+      sema_up (&pong);
+    }
+}
+
+void
+test_ctxsw (void) 
+{
+  uint64_t start, cycles;
+  int i;
+
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  thread_create ("partner", thread_get_priority (), partner, NULL);
+
+  /* Warm up, then time the rest. */
+  sema_up (&ping);
+  sema_down (&pong);
+  start = rdtsc ();
+  for (i = 1; i < ROUND_CNT; i++) 
+    {
+      sema_up (&ping);
+      sema_down (&pong);
+    }
+  cycles = rdtsc () - start;
+
+  msg ("%d switches", 2 * (ROUND_CNT - 1));
+  printf ("ctxsw: %llu cycles per switch\n",
+          cycles / (2 * (ROUND_CNT - 1)));
+  pass ();
+}
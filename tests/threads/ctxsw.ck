@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+# The cycle count depends on the machine, so only its presence is
+# checked.
+fail "No \"cycles per switch\" line\n"
+  if !grep (/^ctxsw: \d+ cycles per switch$/, @output);
+fail "Test did not pass\n" if !grep (/^\(ctxsw\) PASS$/, @output);
+pass;
@@ -0,0 +1,94 @@
+/* Checks read-copy-update: a reader preempted inside its read-side
+   section holds up the grace period of an element unlinked under it,
+   can still walk on from that element, and the element's callback and
+   a synchronize_rcu() caller both run only after the reader is done. */
+
+#include <stdio.h>
+#include <list.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/rcu.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+struct item 
+  {
+    int value;
+    struct list_elem elem;
+    struct rcu_head rcu;
+  };
+
+static struct list items;
+static struct item a, b;
+static volatile bool reader_in, go, reader_done, synced, freed;
+static int visited;
+
+static void
+reader (void *aux UNUSED) 
+{
+  struct list_elem *e;
+
+  rcu_read_lock ();
+  e = list_begin_rcu (&items);
+  reader_in = true;
+  while (!go)
+    thread_yield ();
+  for (; e != list_end (&items); e = list_next_rcu (e)) 
+    {
+      if (list_entry (e, struct item, elem)->value < 0)
+        fail ("reader saw a freed item");
+      visited++;
+    }
+  reader_done = true;
+  rcu_read_unlock ();
+}
+
+static void
+syncer (void *aux UNUSED) 
+{
+  synchronize_rcu ();
+  if (!reader_done)
+    fail ("synchronize_rcu() returned under a reader");
+  synced = true;
+}
+
+static void
+item_free (struct rcu_head *head UNUSED) 
+{
+  if (!reader_done)
+    fail ("callback ran under a reader");
+  a.value = -1;
+  freed = true;
+}
+
+void
+test_rcu (void) 
+{
+  list_init (&items);
+  a.value = 1;
+  b.value = 2;
+  list_push_back_rcu (&items, &a.elem);
+  list_push_back_rcu (&items, &b.elem);
+
+  thread_create ("reader", PRI_DEFAULT, reader, NULL);
+  while (!reader_in)
+    thread_yield ();
+
+  /* Unlink the item the reader stands on. */
+  list_remove_rcu (&a.elem);
+  call_rcu (&a.rcu, item_free);
+  thread_create ("syncer", PRI_DEFAULT, syncer, NULL);
+
+  timer_sleep (10);
+  if (synced || freed)
+    fail ("grace period ended under a preempted reader");
+  msg ("grace period waits for the reader");
+
+  go = true;
+  timer_sleep (10);
+  if (!synced || !freed)
+    fail ("grace period did not end after the reader");
+  if (visited != 2)
+    fail ("reader visited %d items, expected 2", visited);
+  msg ("grace period ended after the reader");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rcu) begin
+(rcu) grace period waits for the reader
+(rcu) grace period ended after the reader
+(rcu) end
+EOF
+pass;
@@ -0,0 +1,68 @@
+/* The main thread and a second reader both hold an rwlock for
+   reading when a high-priority writer blocks on it.  The writer
+   must donate its priority to both readers, including the one that
+   is itself blocked on a semaphore, and the donations must be
+   returned when the readers release the lock. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct rwlock_donate_data 
+  {
+    struct rwlock rw;
+    struct semaphore go;
+  };
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_donate (void) 
+{
+  struct rwlock_donate_data data;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&data.rw);
+  sema_init (&data.go, 0);
+  rwlock_acquire_read (&data.rw);
+  thread_create ("reader", PRI_DEFAULT + 1, reader_thread_func, &data);
+  thread_create ("writer", PRI_DEFAULT + 5, writer_thread_func, &data);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 5, thread_get_priority ());
+  sema_up (&data.go);
+  rwlock_release_read (&data.rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+reader_thread_func (void *data_) 
+{
+  struct rwlock_donate_data *data = data_;
+
+  rwlock_acquire_read (&data->rw);
+  sema_down (&data->go);
+  msg ("reader: should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 5, thread_get_priority ());
+  rwlock_release_read (&data->rw);
+  msg ("reader: done");
+}
+
+static void
+writer_thread_func (void *data_) 
+{
+  struct rwlock_donate_data *data = data_;
+
+  rwlock_acquire_write (&data->rw);
+  msg ("writer: got the lock for writing");
+  rwlock_release_write (&data->rw);
+  msg ("writer: done");
+}
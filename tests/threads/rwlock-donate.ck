@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate) begin
+(rwlock-donate) This thread should have priority 36.  Actual priority: 36.
+(rwlock-donate) reader: should have priority 36.  Actual priority: 36.
+(rwlock-donate) writer: got the lock for writing
+(rwlock-donate) writer: done
+(rwlock-donate) reader: done
+(rwlock-donate) This thread should have priority 31.  Actual priority: 31.
+(rwlock-donate) end
+EOF
+pass;
@@ -0,0 +1,56 @@
+/* The main thread acquires an rwlock for reading.  Two
+   higher-priority readers then acquire it too without blocking,
+   while a higher-priority writer has to wait until the main thread
+   releases its read hold. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_readers (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rwlock_acquire_read (&rw);
+  thread_create ("reader 0", PRI_DEFAULT + 1, reader_thread_func, &rw);
+  thread_create ("reader 1", PRI_DEFAULT + 1, reader_thread_func, &rw);
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread_func, &rw);
+  msg ("Readers shared the lock; the writer must still be waiting.");
+  rwlock_release_read (&rw);
+  msg ("The writer must already have finished.");
+}
+
+static void
+reader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_read (rw);
+  msg ("%s: got the lock for reading", thread_name ());
+  rwlock_release_read (rw);
+  msg ("%s: done", thread_name ());
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_write (rw);
+  msg ("writer: got the lock for writing");
+  rwlock_release_write (rw);
+  msg ("writer: done");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-readers) begin
+(rwlock-readers) reader 0: got the lock for reading
+(rwlock-readers) reader 0: done
+(rwlock-readers) reader 1: got the lock for reading
+(rwlock-readers) reader 1: done
+(rwlock-readers) Readers shared the lock; the writer must still be waiting.
+(rwlock-readers) writer: got the lock for writing
+(rwlock-readers) writer: done
+(rwlock-readers) The writer must already have finished.
+(rwlock-readers) end
+EOF
+pass;
@@ -0,0 +1,49 @@
+/* Measures how fast kernel threads can be created and reaped.
+
+   Creates short-lived threads one after another, each of which ups a
+   semaphore and exits, and waits for each before creating the next.
+   Once the first thread has died, every thread_create() should find a
+   page in the thread cache.  Reports the average number of TSC cycles
+   per thread. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define SPAWN_CNT 2000
+
+static void
+worker (void *done_) 
+{
+  struct semaphore *done = done_;
+
+  sema_up (done);
+}
+
+void
+test_spawn (void) 
+{
+  struct semaphore done;
+  uint64_t start, cycles;
+  int i;
+
+  sema_init (&done, 0);
+  start = rdtsc ();
+  for (i = 0; i < SPAWN_CNT; i++) 
+    {
+      /* A lower priority lets us run on until we block, as a
+         spawner that queues work would. */
+      if (thread_create ("worker", thread_get_priority () - 1, worker,
+                         &done) == TID_ERROR)
+        fail ("thread_create() failed after %d threads", i);
+      sema_down (&done);
+    }
+  cycles = rdtsc () - start;
+
+  msg ("%d threads spawned", SPAWN_CNT);
+  printf ("spawn: %llu cycles per thread\n", cycles / SPAWN_CNT);
+  pass ();
+}
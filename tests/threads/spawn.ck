@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+# The cycle count depends on the machine, so only its presence is
+# checked.
+fail "No \"cycles per thread\" line\n"
+  if !grep (/^spawn: \d+ cycles per thread$/, @output);
+fail "Test did not pass\n" if !grep (/^\(spawn\) PASS$/, @output);
+pass;
@@ -0,0 +1,87 @@
+/* Checks wait queues: wake_up() wakes every shared waiter but only
+   one exclusive waiter, a waiter whose predicate still fails goes
+   back to sleep, and a timed wait returns false once its time is up. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define EXCL_CNT 3
+#define SHARED_CNT 2
+
+static struct wait_queue wq;
+static int tokens;              /* Taken by exclusive waiters. */
+static bool gate_open;          /* Awaited by shared waiters. */
+static int excl_done, shared_done;
+
+static bool
+token_ready (void *aux UNUSED) 
+{
+  return tokens > 0;
+}
+
+static bool
+is_open (void *aux UNUSED) 
+{
+  return gate_open;
+}
+
+static void
+excl_waiter (void *aux UNUSED) 
+{
+  enum intr_level old_level;
+
+  wait_event_exclusive (&wq, token_ready, NULL);
+  old_level = intr_disable ();
+  tokens--;
+  excl_done++;
+  intr_set_level (old_level);
+}
+
+static void
+shared_waiter (void *aux UNUSED) 
+{
+  wait_event (&wq, is_open, NULL);
+  shared_done++;
+}
+
+void
+test_waitqueue (void) 
+{
+  int i, woken;
+  int64_t start;
+
+  /* This test relies on strict priorities. */
+  ASSERT (!thread_mlfqs && !thread_cfs);
+
+  wait_queue_init (&wq);
+  for (i = 0; i < EXCL_CNT; i++)
+    thread_create ("excl", PRI_DEFAULT + 1, excl_waiter, NULL);
+  for (i = 0; i < SHARED_CNT; i++)
+    thread_create ("shared", PRI_DEFAULT + 1, shared_waiter, NULL);
+
+  /* Nothing to wait for yet: a wake-up puts everyone back to sleep. */
+  woken = wake_up (&wq);
+  msg ("woke %d with nothing ready, %d exclusive done", woken, excl_done);
+
+  gate_open = true;
+  tokens = 1;
+  woken = wake_up (&wq);
+  msg ("woke %d: %d shared and %d exclusive done", woken, shared_done,
+       excl_done);
+
+  tokens = 2;
+  woken = wake_up_all (&wq);
+  msg ("woke %d more: %d exclusive done", woken, excl_done);
+
+  start = timer_ticks ();
+  if (wait_event_timeout (&wq, token_ready, NULL, true, 3))
+    fail ("timed wait succeeded with no tokens");
+  if (timer_elapsed (start) < 3)
+    fail ("timed wait returned early");
+  msg ("timed wait timed out");
+  pass ();
+}
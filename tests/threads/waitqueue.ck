@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(waitqueue) begin
+(waitqueue) woke 3 with nothing ready, 0 exclusive done
+(waitqueue) woke 3: 2 shared and 1 exclusive done
+(waitqueue) woke 2 more: 3 exclusive done
+(waitqueue) timed wait timed out
+(waitqueue) PASS
+(waitqueue) end
+EOF
+pass;
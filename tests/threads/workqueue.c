@@ -0,0 +1,82 @@
+/* Checks the workqueue facility: works run in order in their queue's
+   worker thread with interrupts on, a pending work cannot be queued
+   twice, a cancelled work never runs, and a delayed work is queued
+   from the timer interrupt and runs afterward in system_wq's worker. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+static int order[3];
+static int order_cnt;
+static bool ran_in_worker;
+
+static void
+record (void *aux) 
+{
+  order[order_cnt++] = (int) (long) aux;
+  if (strcmp (thread_name (), "test-wq") == 0 && intr_get_level () == INTR_ON)
+    ran_in_worker = true;
+}
+
+static void
+never (void *aux UNUSED) 
+{
+  fail ("cancelled work ran");
+}
+
+static void
+delayed (void *done) 
+{
+  if (strcmp (thread_name (), "events") == 0 && !intr_context ())
+    sema_up (done);
+}
+
+void
+test_workqueue (void) 
+{
+  struct workqueue *wq;
+  struct work w[3], cancelled;
+  struct delayed_work dw;
+  struct semaphore done;
+  int64_t start;
+  int i;
+
+  /* A worker below our priority runs only once we block. */
+  wq = workqueue_create ("test-wq", thread_get_priority () - 1);
+  ASSERT (wq != NULL);
+
+  for (i = 0; i < 3; i++) 
+    {
+      work_init (&w[i], record, (void *) (long) i);
+      queue_work (wq, &w[i]);
+    }
+  if (queue_work (wq, &w[0]))
+    fail ("queued a pending work twice");
+  work_init (&cancelled, never, NULL);
+  queue_work (wq, &cancelled);
+  if (!cancel_work (&cancelled))
+    fail ("could not cancel a pending work");
+
+  flush_workqueue (wq);
+  if (order_cnt != 3 || order[0] != 0 || order[1] != 1 || order[2] != 2)
+    fail ("works ran out of order");
+  if (!ran_in_worker)
+    fail ("works did not run in the worker with interrupts on");
+  msg ("works ran in order in the worker");
+
+  sema_init (&done, 0);
+  delayed_work_init (&dw, delayed, &done);
+  start = timer_ticks ();
+  queue_delayed_work (system_wq, &dw, 5);
+  sema_down (&done);
+  if (timer_elapsed (start) < 5)
+    fail ("delayed work ran early");
+  msg ("delayed work ran in system_wq");
+  pass ();
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) works ran in order in the worker
+(workqueue) delayed work ran in system_wq
+(workqueue) PASS
+(workqueue) end
+EOF
+pass;
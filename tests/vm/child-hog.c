@@ -0,0 +1,53 @@
+/* Child process of frame-limit-evict.
+   Sets a small resident-frame limit and touches far more pages than
+   that, tells the parent through "hog-flag", waits there until the
+   parent is done, and checks that its pages read back intact. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 128
+#define LIMIT 16
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+
+/* Returns the byte in FD's file. */
+static char
+flag_get (int fd)
+{
+  char c = 0;
+
+  seek (fd, 0);
+  read (fd, &c, 1);
+  return c;
+}
+
+int
+main (void)
+{
+  char c = '1';
+  size_t i;
+  int fd;
+
+  test_name = "child-hog";
+  if (frame_limit (LIMIT) != 0)
+    fail ("frame_limit");
+  if ((fd = open ("hog-flag")) < 2)
+    fail ("open \"hog-flag\"");
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    memset (buf + i * PAGE_SIZE, i, PAGE_SIZE);
+  seek (fd, 0);
+  write (fd, &c, 1);
+  while (flag_get (fd) != '2')
+    continue;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (buf[i * PAGE_SIZE] != (char) i
+        || buf[i * PAGE_SIZE + PAGE_SIZE - 1] != (char) i)
+      fail ("page %zu corrupted", i);
+  return 0;
+}
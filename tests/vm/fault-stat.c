@@ -0,0 +1,53 @@
+/* Checks that fault_stat() counts first-touch and stack growth
+   faults. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 8
+#define STACK_PAGES 4
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+
+static unsigned long long
+fault_count (int kind)
+{
+	struct fault_stat st;
+	CHECK (fault_stat (kind, &st) == 0, "fault_stat (%d)", kind);
+	return st.count;
+}
+
+static void
+grow_stack (void)
+{
+	volatile char stack_obj[STACK_PAGES * PAGE_SIZE];
+	size_t i;
+
+	for (i = 0; i < STACK_PAGES; i++)
+		stack_obj[i * PAGE_SIZE] = i;
+}
+
+void
+test_main (void)
+{
+	unsigned long long before, after;
+	struct fault_stat st;
+	size_t i;
+
+	before = fault_count (FAULT_MINOR);
+	for (i = 0; i < PAGE_COUNT; i++)
+		buf[i * PAGE_SIZE] = i;
+	after = fault_count (FAULT_MINOR);
+	CHECK (after - before >= PAGE_COUNT, "touching %d pages took minor faults",
+			PAGE_COUNT);
+
+	before = fault_count (FAULT_STACK);
+	grow_stack ();
+	after = fault_count (FAULT_STACK);
+	CHECK (after - before >= STACK_PAGES - 1, "stack grew by fault");
+
+	CHECK (fault_stat (FAULT_INVALID + 1, &st) == -1, "reject bad fault kind");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fault-stat) begin
+(fault-stat) fault_stat (0)
+(fault-stat) fault_stat (0)
+(fault-stat) touching 8 pages took minor faults
+(fault-stat) fault_stat (3)
+(fault-stat) fault_stat (3)
+(fault-stat) stack grew by fault
+(fault-stat) reject bad fault kind
+(fault-stat) end
+EOF
+pass;
@@ -0,0 +1,59 @@
+/* Runs a child that sets a small resident-frame limit and goes far
+   over it, then touches pages of its own until frames run out.
+   Eviction must take the child's frames, which are over its limit,
+   before any of the parent's, which has none. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 96
+
+static char buf[PAGE_COUNT * PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+/* Returns the byte in FD's file. */
+static char
+flag_get (int fd)
+{
+	char c = 0;
+
+	seek (fd, 0);
+	read (fd, &c, 1);
+	return c;
+}
+
+void
+test_main (void)
+{
+	unsigned char vec[PAGE_COUNT];
+	char c = '2';
+	pid_t child;
+	size_t i;
+	int fd;
+
+	CHECK (create ("hog-flag", 1), "create \"hog-flag\"");
+	CHECK ((fd = open ("hog-flag")) > 1, "open \"hog-flag\"");
+
+	child = fork ("child-hog");
+	if (child == 0) {
+		if (exec ("child-hog") == -1)
+			fail ("exec \"child-hog\"");
+	}
+	while (flag_get (fd) != '1')
+		continue;
+	msg ("child-hog is over its limit");
+
+	for (i = 0; i < PAGE_COUNT; i++)
+		memset (buf + i * PAGE_SIZE, i, PAGE_SIZE);
+	CHECK (mincore (buf, sizeof buf, vec) == 0, "mincore");
+	for (i = 0; i < PAGE_COUNT; i++)
+		if (vec[i] != MINCORE_RESIDENT)
+			fail ("page %zu evicted while child-hog was over its limit", i);
+	msg ("%d pages resident", PAGE_COUNT);
+
+	seek (fd, 0);
+	write (fd, &c, 1);
+	CHECK (wait (child) == 0, "wait for child-hog");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(frame-limit-evict) begin
+(frame-limit-evict) create "hog-flag"
+(frame-limit-evict) open "hog-flag"
+(frame-limit-evict) child-hog is over its limit
+(frame-limit-evict) mincore
+(frame-limit-evict) 96 pages resident
+(frame-limit-evict) wait for child-hog
+(frame-limit-evict) end
+EOF
+pass;
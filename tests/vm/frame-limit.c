@@ -0,0 +1,32 @@
+/* Sets a soft resident-frame limit, then touches more pages than the
+   limit allows.  The limit only steers eviction, so every page must
+   still read back intact. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 64
+#define LIMIT 16
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+	size_t i;
+
+	CHECK (frame_limit (-1) == 0, "no limit by default");
+	CHECK (frame_limit (LIMIT) == 0, "set limit to %d pages", LIMIT);
+	CHECK (frame_limit (-1) == LIMIT, "query limit");
+
+	for (i = 0; i < PAGE_COUNT; i++)
+		memset (buf + i * PAGE_SIZE, i, PAGE_SIZE);
+	for (i = 0; i < PAGE_COUNT; i++)
+		if (buf[i * PAGE_SIZE] != (char) i
+				|| buf[i * PAGE_SIZE + PAGE_SIZE - 1] != (char) i)
+			fail ("page %zu corrupted", i);
+	msg ("%d pages intact", PAGE_COUNT);
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(frame-limit) begin
+(frame-limit) no limit by default
+(frame-limit) set limit to 16 pages
+(frame-limit) query limit
+(frame-limit) 64 pages intact
+(frame-limit) end
+EOF
+pass;
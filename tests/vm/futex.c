@@ -0,0 +1,35 @@
+/* Exercises futex() and the user-level mutex built on it without
+   any contention: a wait on a stale value must return at once, a
+   wake with no sleepers must wake nobody, and mutex operations must
+   behave without ever needing to sleep. */
+
+#include <synch.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int word = 5;
+static struct mutex m = MUTEX_INITIALIZER;
+static struct condvar cv = CONDVAR_INITIALIZER;
+
+void
+test_main (void)
+{
+	CHECK (futex (&word, FUTEX_WAIT, 6) == -1, "wait on stale value returns");
+	CHECK (futex (&word, FUTEX_WAKE, 1) == 0, "wake with no sleepers");
+	CHECK (futex ((int *) 0x8004000000, FUTEX_WAIT, 0) == -1,
+	       "wait on kernel address fails");
+	CHECK (futex ((int *) ((char *) &word + 1), FUTEX_WAIT, 5) == -1,
+	       "wait on misaligned address fails");
+
+	mutex_lock (&m);
+	CHECK (!mutex_trylock (&m), "trylock fails while locked");
+	mutex_unlock (&m);
+	CHECK (mutex_trylock (&m), "trylock succeeds once unlocked");
+	mutex_unlock (&m);
+	CHECK (m.state == 0, "mutex left unlocked");
+
+	condvar_signal (&cv);
+	condvar_broadcast (&cv);
+	msg ("signals with no waiters");
+}
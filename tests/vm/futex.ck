@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(futex) begin
+(futex) wait on stale value returns
+(futex) wake with no sleepers
+(futex) wait on kernel address fails
+(futex) wait on misaligned address fails
+(futex) trylock fails while locked
+(futex) trylock succeeds once unlocked
+(futex) mutex left unlocked
+(futex) signals with no waiters
+(futex) end
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Checks that lockstat() either reports that the kernel was built
+   without LOCKSTAT or returns lock sites most-waited first, each
+   with no more contended acquisitions than acquisitions. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SITE_MAX 16
+
+static struct lockstat st[SITE_MAX];
+
+void
+test_main (void)
+{
+	int cnt = lockstat (st, SITE_MAX);
+	int i;
+
+	if (cnt < 0) {
+		msg ("lockstat not built in");
+		return;
+	}
+	if (cnt > SITE_MAX)
+		fail ("lockstat returned %d sites for %d slots", cnt, SITE_MAX);
+	for (i = 0; i < cnt; i++) {
+		if (st[i].contended > st[i].acquired)
+			fail ("%s at %s: contended more often than acquired",
+					st[i].name, st[i].site);
+		if (i > 0 && st[i].wait_cycles > st[i - 1].wait_cycles)
+			fail ("%s at %s: out of order", st[i].name, st[i].site);
+	}
+	CHECK (lockstat (st, 0) == 0, "lockstat (0)");
+	msg ("lock sites sorted by wait time");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF', <<'EOF']);
+(lockstat) begin
+(lockstat) lockstat (0)
+(lockstat) lock sites sorted by wait time
+(lockstat) end
+EOF
+(lockstat) begin
+(lockstat) lockstat not built in
+(lockstat) end
+EOF
+pass;
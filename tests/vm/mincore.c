@@ -0,0 +1,36 @@
+/* Checks that mincore() tells untouched pages from resident ones. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 4
+
+static char buf[PAGE_COUNT * PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+	unsigned char vec[PAGE_COUNT];
+	size_t i;
+
+	CHECK (mincore (buf, sizeof buf, vec) == 0, "mincore before touching");
+	for (i = 0; i < PAGE_COUNT; i++)
+		if (vec[i] != MINCORE_UNTOUCHED)
+			fail ("page %zu: expected untouched, got %d", i, vec[i]);
+
+	buf[0] = 1;
+	buf[2 * PAGE_SIZE] = 1;
+	CHECK (mincore (buf, sizeof buf, vec) == 0, "mincore after touching");
+	for (i = 0; i < PAGE_COUNT; i++) {
+		int expected = i % 2 == 0 ? MINCORE_RESIDENT : MINCORE_UNTOUCHED;
+		if (vec[i] != expected)
+			fail ("page %zu: expected %d, got %d", i, expected, vec[i]);
+	}
+
+	CHECK (mincore (buf + 1, PAGE_SIZE, vec) == -1, "misaligned address");
+	CHECK (mincore ((void *) 0x10000000, PAGE_SIZE, vec) == -1,
+			"unmapped range");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mincore) begin
+(mincore) mincore before touching
+(mincore) mincore after touching
+(mincore) misaligned address
+(mincore) unmapped range
+(mincore) end
+EOF
+pass;
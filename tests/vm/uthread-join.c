@@ -0,0 +1,59 @@
+/* Starts several user threads that write into shared memory and
+   through a shared file descriptor, and checks that each one's exit
+   status comes back through uthread_join(). */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+
+static int slots[THREAD_CNT];
+static int fd;
+
+static int
+worker (void *aux)
+{
+	int i = (int) (long) aux;
+	char c = 'a' + i;
+	int local[64];
+
+	/* Touch this thread's own stack, then the shared data. */
+	for (int j = 0; j < 64; j++)
+		local[j] = i * j;
+	slots[i] = local[63] + 1;
+	if (write (fd, &c, 1) != 1)
+		return -1;
+	return 100 + i;
+}
+
+void
+test_main (void)
+{
+	pid_t tids[THREAD_CNT];
+	char buf[THREAD_CNT];
+	int i;
+
+	CHECK (create ("shared", 0), "create \"shared\"");
+	CHECK ((fd = open ("shared")) > 1, "open \"shared\"");
+
+	for (i = 0; i < THREAD_CNT; i++)
+		CHECK ((tids[i] = uthread_create (worker, (void *) (long) i)) != PID_ERROR,
+		       "create thread %d", i);
+	for (i = 0; i < THREAD_CNT; i++)
+		CHECK (uthread_join (tids[i]) == 100 + i, "join thread %d", i);
+	CHECK (uthread_join (tids[0]) == -1, "second join fails");
+
+	for (i = 0; i < THREAD_CNT; i++)
+		if (slots[i] != i * 63 + 1)
+			fail ("slots[%d] is %d, not %d", i, slots[i], i * 63 + 1);
+	msg ("threads wrote shared memory");
+
+	CHECK (filesize (fd) == THREAD_CNT, "threads wrote shared file");
+	seek (fd, 0);
+	CHECK (read (fd, buf, THREAD_CNT) == THREAD_CNT, "read back");
+	for (i = 0; i < THREAD_CNT; i++)
+		if (buf[i] < 'a' || buf[i] >= 'a' + THREAD_CNT)
+			fail ("unexpected byte %d", buf[i]);
+	close (fd);
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(uthread-join) begin
+(uthread-join) create "shared"
+(uthread-join) open "shared"
+(uthread-join) create thread 0
+(uthread-join) create thread 1
+(uthread-join) create thread 2
+(uthread-join) create thread 3
+(uthread-join) join thread 0
+(uthread-join) join thread 1
+(uthread-join) join thread 2
+(uthread-join) join thread 3
+(uthread-join) second join fails
+(uthread-join) threads wrote shared memory
+(uthread-join) threads wrote shared file
+(uthread-join) read back
+(uthread-join) end
+EOF
+pass;
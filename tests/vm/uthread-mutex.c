@@ -0,0 +1,68 @@
+/* Has several user threads increment a shared counter under a
+   user-level mutex, so that they contend and sleep in futex(), and
+   hands a value from thread to thread through a condition variable. */
+
+#include <synch.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define ITER_CNT 2000
+
+static struct mutex m = MUTEX_INITIALIZER;
+static struct condvar cv = CONDVAR_INITIALIZER;
+static int counter;
+static int turn;
+
+static int
+adder (void *aux UNUSED)
+{
+	for (int i = 0; i < ITER_CNT; i++) {
+		mutex_lock (&m);
+		int old = counter;
+		/* Give the other threads a chance to run while we hold m. */
+		for (volatile int j = 0; j < 50; j++)
+			continue;
+		counter = old + 1;
+		mutex_unlock (&m);
+	}
+	return 0;
+}
+
+static int
+relay (void *aux)
+{
+	int i = (int) (long) aux;
+
+	mutex_lock (&m);
+	while (turn != i)
+		condvar_wait (&cv, &m);
+	turn++;
+	condvar_broadcast (&cv);
+	mutex_unlock (&m);
+	return i;
+}
+
+void
+test_main (void)
+{
+	pid_t tids[THREAD_CNT];
+	int i;
+
+	for (i = 0; i < THREAD_CNT; i++)
+		tids[i] = uthread_create (adder, NULL);
+	for (i = 0; i < THREAD_CNT; i++)
+		if (tids[i] == PID_ERROR || uthread_join (tids[i]) != 0)
+			fail ("adder %d failed", i);
+	CHECK (counter == THREAD_CNT * ITER_CNT, "counter is %d", counter);
+	CHECK (m.state == 0, "mutex left unlocked");
+
+	/* Start the relay threads in reverse, so most must wait. */
+	for (i = THREAD_CNT - 1; i >= 0; i--)
+		tids[i] = uthread_create (relay, (void *) (long) i);
+	for (i = 0; i < THREAD_CNT; i++)
+		if (tids[i] == PID_ERROR || uthread_join (tids[i]) != i)
+			fail ("relay %d failed", i);
+	CHECK (turn == THREAD_CNT, "relay finished in order");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(uthread-mutex) begin
+(uthread-mutex) counter is 8000
+(uthread-mutex) mutex left unlocked
+(uthread-mutex) relay finished in order
+(uthread-mutex) end
+EOF
+pass;
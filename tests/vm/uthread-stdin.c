@@ -0,0 +1,48 @@
+/* Exits the process while one of its threads waits for a key from the
+   console and another waits to join that one.  Neither wait ends by
+   itself, so the process only exits if exit() pulls both threads out
+   of the kernel. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static volatile int started;
+static pid_t reader_tid;
+
+static int
+reader (void *aux UNUSED)
+{
+	char c;
+
+	started = 1;
+	read (STDIN_FILENO, &c, 1);
+	return 0;
+}
+
+static int
+joiner (void *aux UNUSED)
+{
+	started = 2;
+	uthread_join (reader_tid);
+	return 0;
+}
+
+void
+test_main (void)
+{
+	CHECK ((reader_tid = uthread_create (reader, NULL)) != PID_ERROR,
+	       "create reader");
+	while (started != 1)
+		continue;
+	CHECK (uthread_create (joiner, NULL) != PID_ERROR, "create joiner");
+	while (started != 2)
+		continue;
+
+	/* Give both threads time to block in the kernel. */
+	for (volatile int i = 0; i < 10000000; i++)
+		continue;
+	msg ("exit");
+	exit (57);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(uthread-stdin) begin
+(uthread-stdin) create reader
+(uthread-stdin) create joiner
+(uthread-stdin) exit
+uthread-stdin: exit(57)
+EOF
+pass;
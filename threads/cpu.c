@@ -0,0 +1,23 @@
+#include "threads/cpu.h"
+
+/* Per-CPU data, indexed by cpu_id().
+
+   Only the boot processor runs: the rest of the kernel counts on
+   intr_disable() for mutual exclusion, which only holds on one CPU.
+   The array still lets RCU and the tracer keep their state per CPU, so
+   that they need no change if more CPUs ever come up. */
+struct cpu cpus[CPU_MAX] = {
+	[0] = { .id = 0, .sched = true },
+};
+
+/* Returns the running CPU, which is always the boot processor. */
+struct cpu *
+cpu_current (void) {
+	return &cpus[0];
+}
+
+/* Returns the running CPU's index in cpus[]. */
+int
+cpu_id (void) {
+	return cpu_current ()->id;
+}
@@ -19,8 +19,12 @@
 #include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
 #include "threads/pte.h"
+#include "threads/rcu.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -89,6 +93,7 @@ main (void) {
 	mem_end = palloc_init ();
 	malloc_init ();
 	paging_init (mem_end);
+	trace_init ();
 
 #ifdef USERPROG
 	tss_init ();
@@ -108,6 +113,9 @@ main (void) {
 	thread_start ();
 	serial_init_queue ();
 	timer_calibrate ();
+	profile_init ();
+	workqueue_init ();
+	rcu_init ();
 
 #ifdef FILESYS
 	/* Initialize file system. */
@@ -224,16 +232,33 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-cfs"))
+			thread_cfs = true;
+		else if (!strcmp (name, "-donate-depth"))
+			donate_depth_max = atoi (value);
+		else if (!strcmp (name, "-trace"))
+			trace_option = true;
+		else if (!strcmp (name, "-profile")) {
+			profile_enabled = true;
+			profile_hz = value != NULL ? atoi (value) : 0;
+		}
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-rl"))
+			vm_frame_limit = atoi (value);
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
 	}
 
+	if (thread_mlfqs && thread_cfs)
+		PANIC ("-mlfqs and -cfs cannot be used together");
+
 	return argv;
 }
 
@@ -331,8 +356,15 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -cfs               Use completely fair scheduler.\n"
+			"  -donate-depth=N    Pass priority donation through N lock holders.\n"
+			"  -profile[=HZ]      Sample kernel and user RIPs, dump at power off.\n"
+			"  -trace             Record tracepoints, dump at power off.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -rl=COUNT          Prefer evicting processes above COUNT resident pages.\n"
 #endif
 			);
 	power_off ();
@@ -359,6 +391,9 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+#ifdef VM
+	vm_print_fault_stats ();
+#endif
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -367,4 +402,9 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef LOCKSTAT
+	lockstat_print (10);
+#endif
+	profile_print ();
+	trace_print ();
 }
@@ -13,6 +13,7 @@
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/gdt.h"
+#include "userprog/syscall.h"
 #endif
 
 /* Number of x86_64 interrupts. */
@@ -344,6 +345,10 @@ intr_handler (struct intr_frame *frame) {
 
 		in_external_intr = true;
 		yield_on_return = false;
+
+		/* The clock is behind while the timer is tickless. */
+		if (frame->vec_no != 0x20)
+			timer_idle_exit ();
 	}
 
 	/* Invoke the interrupt's handler. */
@@ -372,6 +377,12 @@ intr_handler (struct intr_frame *frame) {
 		if (yield_on_return)
 			thread_yield ();
 	}
+
+#ifdef USERPROG
+	/* Another thread of this process may have called exit(). */
+	if (frame->cs == SEL_UCSEG)
+		syscall_exit_if_killed ();
+#endif
 }
 
 /* Dumps interrupt frame F to the console, for debugging. */
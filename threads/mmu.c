@@ -6,8 +6,56 @@
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
+#include "threads/interrupt.h"
 #include "intrinsic.h"
 
+/* Free list of zeroed page-table pages.
+ * Every process creation and exit allocates and releases a whole
+ * subtree of PDPT/PD/PT pages.  Recycling them here skips the kernel
+ * pool's lock and bitmap, and moves the zeroing off the allocation
+ * path: the teardown walk clears each entry as it visits it, so a page
+ * is already zero when it is put back.  The list is threaded through
+ * the first word of each free page.  Pintos runs on a single CPU, so
+ * the per-CPU list is just one list guarded by disabling interrupts. */
+#define PT_CACHE_MAX 64
+
+static uint64_t *pt_cache;
+static size_t pt_cache_cnt;
+
+/* Returns a zeroed page for use as a page table, or a null pointer
+ * if memory is exhausted. */
+static uint64_t *
+pt_page_alloc (void) {
+	enum intr_level old_level = intr_disable ();
+	uint64_t *page = pt_cache;
+	if (page != NULL) {
+		pt_cache = (uint64_t *) page[0];
+		pt_cache_cnt--;
+	}
+	intr_set_level (old_level);
+
+	if (page == NULL)
+		return palloc_get_page (PAL_ZERO);
+	page[0] = 0;
+	return page;
+}
+
+/* Releases page-table page PAGE, which must be all zeros. */
+static void
+pt_page_free (uint64_t *page) {
+	enum intr_level old_level = intr_disable ();
+	if (pt_cache_cnt < PT_CACHE_MAX) {
+		page[0] = (uint64_t) pt_cache;
+		pt_cache = page;
+		pt_cache_cnt++;
+		page = NULL;
+	}
+	intr_set_level (old_level);
+
+	if (page != NULL)
+		palloc_free_page (page);
+}
+
 static uint64_t *
 pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 	// pdp : page directory 테이블의 시작 주소
@@ -18,7 +66,7 @@ pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 		uint64_t *pte = (uint64_t *) pdp[idx];
 		if (!((uint64_t) pte & PTE_P)) {
 			if (create) {
-				uint64_t *new_page = palloc_get_page (PAL_ZERO);
+				uint64_t *new_page = pt_page_alloc ();
 				if (new_page)
 					pdp[idx] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
 				else
@@ -45,7 +93,7 @@ pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
 		uint64_t *pde = (uint64_t *) pdpe[idx];
 		if (!((uint64_t) pde & PTE_P)) {
 			if (create) {
-				uint64_t *new_page = palloc_get_page (PAL_ZERO);
+				uint64_t *new_page = pt_page_alloc ();
 				if (new_page) {
 					pdpe[idx] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
 					allocated = 1;
@@ -57,7 +105,7 @@ pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
 		pte = pgdir_walk (ptov (PTE_ADDR (pdpe[idx])), va, create);
 	}
 	if (pte == NULL && allocated) {
-		palloc_free_page ((void *) ptov (PTE_ADDR (pdpe[idx])));
+		pt_page_free (ptov (PTE_ADDR (pdpe[idx])));
 		pdpe[idx] = 0;
 	}
 	return pte;
@@ -89,7 +137,7 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 		if (!((uint64_t) pdpe & PTE_P)) {
 			// create가 true면 새 페이지 생성
 			if (create) {
-				uint64_t *new_page = palloc_get_page (PAL_ZERO);
+				uint64_t *new_page = pt_page_alloc ();
 				if (new_page) {
 					pml4e[idx] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
 					allocated = 1;
@@ -102,7 +150,7 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 		pte = pdpe_walk (ptov (PTE_ADDR (pml4e[idx])), va, create);
 	}
 	if (pte == NULL && allocated) {
-		palloc_free_page ((void *) ptov (PTE_ADDR (pml4e[idx])));
+		pt_page_free (ptov (PTE_ADDR (pml4e[idx])));
 		pml4e[idx] = 0;
 	}
 	return pte;
@@ -115,7 +163,7 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 // 새 페이지 테이블을 생성해서 반환
 uint64_t *
 pml4_create (void) {
-	uint64_t *pml4 = palloc_get_page (0);
+	uint64_t *pml4 = pt_page_alloc ();
 	if (pml4)
 		memcpy (pml4, base_pml4, PGSIZE);
 	return pml4;
@@ -183,14 +231,20 @@ pml4_for_each (uint64_t *pml4, pte_for_each_func *func, void *aux) {
 	return true;
 }
 
+/* The destroy functions below tear a user address space down in a
+ * single walk.  User frames that are still mapped are freed along with
+ * the tables, so the caller need not clear each page beforehand.  Every
+ * entry is zeroed once visited, leaving the table page ready for the
+ * page-table cache. */
 static void
 pt_destroy (uint64_t *pt) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pt[i]);
 		if (((uint64_t) pte) & PTE_P)
 			palloc_free_page ((void *) PTE_ADDR (pte));
+		pt[i] = 0;
 	}
-	palloc_free_page ((void *) pt);
+	pt_page_free (pt);
 }
 
 static void
@@ -198,9 +252,10 @@ pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
 		if (((uint64_t) pte) & PTE_P)
-			pt_destroy (PTE_ADDR (pte));
+			pt_destroy ((uint64_t *) PTE_ADDR (pte));
+		pdp[i] = 0;
 	}
-	palloc_free_page ((void *) pdp);
+	pt_page_free (pdp);
 }
 
 static void
@@ -209,8 +264,9 @@ pdpe_destroy (uint64_t *pdpe) {
 		uint64_t *pde = ptov((uint64_t *) pdpe[i]);
 		if (((uint64_t) pde) & PTE_P)
 			pgdir_destroy ((void *) PTE_ADDR (pde));
+		pdpe[i] = 0;
 	}
-	palloc_free_page ((void *) pdpe);
+	pt_page_free (pdpe);
 }
 
 /* Destroys pml4e, freeing all the pages it references. */
@@ -227,7 +283,10 @@ pml4_destroy (uint64_t *pml4) {
 	if (((uint64_t) pdpe) & PTE_P)
 		pdpe_destroy ((void *) PTE_ADDR (pdpe));
 
-	palloc_free_page ((void *) pml4);
+	/* The upper entries are the kernel mappings copied in by
+	 * pml4_create (). */
+	memset (pml4, 0, PGSIZE);
+	pt_page_free (pml4);
 }
 
 /* Loads page directory PD into the CPU's page directory base
@@ -0,0 +1,134 @@
+#include "threads/profile.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Sampling profiler.
+
+   Each sample is the RIP the timer interrupt found, user or kernel,
+   counted in a hash table of (rip, count) pairs allocated once per
+   boot.  By default every timer tick takes a sample.  A rate above
+   TIMER_FREQ uses an hrtimer instead: its callback marks a sample due
+   and forces an interrupt, and profile_sample() takes it at the end
+   of that interrupt, where the interrupted frame is at hand.
+
+   profile_print() dumps the table at power-off, one "profile" line
+   per address, for utils/pintos-profile to turn into a flat profile
+   with addr2line. */
+
+/* -profile[=HZ]. */
+bool profile_enabled;
+int profile_hz;
+
+/* Histogram, in PROFILE_PAGES pages. */
+#define PROFILE_PAGES 16
+#define PROFILE_BUCKETS (PROFILE_PAGES * PGSIZE / sizeof (struct profile_bucket))
+
+struct profile_bucket {
+	uint64_t rip;               /* 0 if unused. */
+	uint64_t count;
+};
+
+static struct profile_bucket *buckets;
+static uint64_t sample_cnt;     /* Samples taken. */
+static uint64_t user_cnt;       /* ...of which in user code. */
+static uint64_t dropped_cnt;    /* ...of which found the table full. */
+
+/* Tick sampling: the tick last sampled. */
+static int64_t last_tick = -1;
+
+/* HZ sampling. */
+static struct hrtimer sample_timer;
+static int64_t sample_period_ns;
+static bool sample_due;
+
+static void sample_timer_fire (void *aux);
+
+/* Allocates the histogram and starts sampling, if -profile was given.
+   Must be called after timer_calibrate(). */
+void
+profile_init (void) {
+	if (!profile_enabled)
+		return;
+
+	buckets = palloc_get_multiple (PAL_ZERO, PROFILE_PAGES);
+	if (buckets == NULL) {
+		printf ("profile: out of memory, not profiling\n");
+		profile_enabled = false;
+		return;
+	}
+
+	if (profile_hz > TIMER_FREQ && hrtimer_available ()) {
+		sample_period_ns = 1000000000 / profile_hz;
+		hrtimer_init (&sample_timer, sample_timer_fire, NULL);
+		hrtimer_start (&sample_timer, sample_period_ns);
+	} else
+		profile_hz = TIMER_FREQ;
+	printf ("profile: sampling at %d Hz\n", profile_hz);
+}
+
+static void
+sample_timer_fire (void *aux UNUSED) {
+	sample_due = true;
+	hrtimer_start (&sample_timer, sample_period_ns);
+}
+
+/* Counts RIP in the histogram. */
+static void
+record (uint64_t rip) {
+	size_t i = (rip * 0x9e3779b97f4a7c15ULL) >> 32;
+
+	for (size_t n = 0; n < PROFILE_BUCKETS; n++) {
+		struct profile_bucket *b = &buckets[(i + n) % PROFILE_BUCKETS];
+		if (b->rip == rip || b->rip == 0) {
+			b->rip = rip;
+			b->count++;
+			return;
+		}
+	}
+	dropped_cnt++;
+}
+
+/* Called by the timer interrupt handler, with F the interrupted
+   frame, at the end of every timer interrupt. */
+void
+profile_sample (struct intr_frame *f) {
+	if (buckets == NULL)
+		return;
+
+	if (sample_period_ns != 0) {
+		if (!sample_due)
+			return;
+		sample_due = false;
+	} else {
+		if (timer_ticks () == last_tick)
+			return;
+		last_tick = timer_ticks ();
+	}
+
+	sample_cnt++;
+	if (is_user_vaddr (f->rip))
+		user_cnt++;
+	record (f->rip);
+}
+
+/* Dumps the histogram: a summary line, then "profile K|U RIP COUNT"
+   for every sampled address, K for kernel and U for user code. */
+void
+profile_print (void) {
+	if (buckets == NULL)
+		return;
+
+	printf ("Profile: %llu samples (%llu user, %llu dropped) at %d Hz\n",
+			(unsigned long long) sample_cnt, (unsigned long long) user_cnt,
+			(unsigned long long) dropped_cnt, profile_hz);
+	for (size_t i = 0; i < PROFILE_BUCKETS; i++)
+		if (buckets[i].rip != 0)
+			printf ("profile %c %#llx %llu\n",
+					is_user_vaddr (buckets[i].rip) ? 'U' : 'K',
+					(unsigned long long) buckets[i].rip,
+					(unsigned long long) buckets[i].count);
+}
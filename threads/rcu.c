@@ -0,0 +1,191 @@
+#include "threads/rcu.h"
+#include <debug.h>
+#include <stddef.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+
+/* Grace periods.
+
+   A CPU passes through a quiescent state whenever the thread it runs
+   is outside any read-side section: at each timer tick that finds
+   rcu_nesting == 0 (the idle thread included) and at each context
+   switch.  A grace period that started at some point is over once
+   every CPU that runs threads has passed a quiescent state since then.
+
+   Read-side sections may be preempted, so a context switch away from
+   a reader does not end the reader.  schedule() puts such a thread on
+   `blocked_readers', tagged with the last grace period its CPU had
+   reported before the reader began; the reader holds up every later
+   grace period until its outermost rcu_read_unlock().
+
+   Like the rest of the scheduler this state is protected by turning
+   interrupts off, which suffices while one CPU runs threads. */
+
+static uint64_t gp_seq;                 /* Last grace period started. */
+static uint64_t gp_done;                /* Last grace period completed. */
+static struct list blocked_readers;     /* Preempted readers. */
+
+/* Callbacks waiting for a grace period, in order of their `gp'. */
+static struct list callbacks;
+
+/* Runs callbacks whose grace period is over.  A queue of its own, so
+   that synchronize_rcu() works from system_wq's worker too. */
+static struct workqueue *rcu_wq;
+static struct work rcu_work;
+
+static void rcu_do_callbacks (void *aux);
+
+/* Initializes RCU.  Must be called after workqueue_init(). */
+void
+rcu_init (void) {
+	list_init (&blocked_readers);
+	list_init (&callbacks);
+	work_init (&rcu_work, rcu_do_callbacks, NULL);
+	rcu_wq = workqueue_create ("rcu", PRI_DEFAULT);
+	if (rcu_wq == NULL)
+		PANIC ("cannot create rcu workqueue");
+}
+
+/* Begins a read-side section.  Sections nest. */
+void
+rcu_read_lock (void) {
+	thread_current ()->rcu_nesting++;
+	barrier ();
+}
+
+/* Ends a read-side section. */
+void
+rcu_read_unlock (void) {
+	struct thread *t = thread_current ();
+
+	ASSERT (t->rcu_nesting > 0);
+	barrier ();
+	if (--t->rcu_nesting == 0 && t->rcu_blocked) {
+		enum intr_level old_level = intr_disable ();
+		list_remove (&t->rcu_elem);
+		t->rcu_blocked = false;
+		intr_set_level (old_level);
+	}
+}
+
+/* Returns true if grace period GP is over. */
+static bool
+gp_complete (uint64_t gp) {
+	struct list_elem *e;
+
+	for (int i = 0; i < CPU_MAX; i++)
+		if (cpus[i].sched && cpus[i].rcu_qs < gp)
+			return false;
+	for (e = list_begin (&blocked_readers); e != list_end (&blocked_readers);
+			e = list_next (e))
+		if (list_entry (e, struct thread, rcu_elem)->rcu_gp < gp)
+			return false;
+	return true;
+}
+
+/* Ends the current grace period if it is over, hands its callbacks to
+   the worker and starts the next one if callbacks wait for it. */
+static void
+rcu_advance (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (gp_seq == gp_done || !gp_complete (gp_seq))
+		return;
+	gp_done = gp_seq;
+	if (list_empty (&callbacks))
+		return;
+	if (list_entry (list_front (&callbacks), struct rcu_head, elem)->gp
+			<= gp_done)
+		queue_work (rcu_wq, &rcu_work);
+	if (list_entry (list_back (&callbacks), struct rcu_head, elem)->gp
+			> gp_done)
+		gp_seq++;
+}
+
+/* Called by schedule(), with interrupts off, before switching away
+   from CURR. */
+void
+rcu_note_context_switch (struct thread *curr) {
+	struct cpu *c = cpu_current ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (curr->rcu_nesting > 0 && !curr->rcu_blocked) {
+		curr->rcu_blocked = true;
+		curr->rcu_gp = c->rcu_qs;
+		list_push_back (&blocked_readers, &curr->rcu_elem);
+	}
+	c->rcu_qs = gp_seq;
+}
+
+/* Called by the timer interrupt handler at each timer tick. */
+void
+rcu_tick (void) {
+	if (thread_current ()->rcu_nesting == 0)
+		cpu_current ()->rcu_qs = gp_seq;
+	rcu_advance ();
+}
+
+/* Arranges for FUNC (HEAD) to be called, in a kernel thread, once
+   every read-side section in progress now has ended.  May be called
+   from an interrupt handler. */
+void
+call_rcu (struct rcu_head *head, rcu_func *func) {
+	enum intr_level old_level = intr_disable ();
+
+	head->func = func;
+	if (gp_seq == gp_done)
+		head->gp = ++gp_seq;
+	else
+		head->gp = gp_seq + 1;
+	list_push_back (&callbacks, &head->elem);
+	intr_set_level (old_level);
+}
+
+static void
+rcu_do_callbacks (void *aux UNUSED) {
+	enum intr_level old_level = intr_disable ();
+
+	while (!list_empty (&callbacks)) {
+		struct rcu_head *head =
+			list_entry (list_front (&callbacks), struct rcu_head, elem);
+		if (head->gp > gp_done)
+			break;
+		list_pop_front (&callbacks);
+		intr_set_level (old_level);
+		head->func (head);
+		old_level = intr_disable ();
+	}
+	intr_set_level (old_level);
+}
+
+/* synchronize_rcu() waits on one of these. */
+struct rcu_synchronize {
+	struct rcu_head head;
+	struct semaphore done;
+};
+
+static void
+wakeme_after_rcu (struct rcu_head *head) {
+	struct rcu_synchronize *rs = (struct rcu_synchronize *)
+		((uint8_t *) head - offsetof (struct rcu_synchronize, head));
+
+	sema_up (&rs->done);
+}
+
+/* Waits until every read-side section in progress now has ended.
+   Must not be called inside one, nor from a callback. */
+void
+synchronize_rcu (void) {
+	struct rcu_synchronize rs;
+
+	ASSERT (!intr_context ());
+	ASSERT (thread_current ()->rcu_nesting == 0);
+
+	sema_init (&rs.done, 0);
+	call_rcu (&rs.head, wakeme_after_rcu);
+	sema_down (&rs.done);
+}
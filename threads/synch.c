@@ -31,6 +31,25 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Next sequence number for a semaphore or condition waiter.  Waiters
+	 of equal priority are woken in the order they started waiting. */
+static uint64_t next_wait_seq;
+
+static int rwlock_waiter_priority(const struct rwlock* rw);
+
+/* Orders semaphore waiters by priority, then by arrival. */
+static bool
+sema_waiter_less(const struct heap_elem* a, const struct heap_elem* b,
+	void* aux UNUSED) {
+	const struct thread* ta = heap_entry(a, struct thread, wait_elem);
+	const struct thread* tb = heap_entry(b, struct thread, wait_elem);
+
+	if (ta->priority != tb->priority)
+		return ta->priority > tb->priority;
+	return ta->wait_seq < tb->wait_seq;
+}
 
 			/* Initializes semaphore SEMA to VALUE.  A semaphore is a
 					nonnegative integer along with two atomic operators for
@@ -47,7 +66,7 @@ sema_init(struct semaphore* sema, unsigned value) {
 	ASSERT(sema != NULL);
 
 	sema->value = value;
-	list_init(&sema->waiters);
+	heap_init(&sema->waiters, sema_waiter_less, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -67,7 +86,13 @@ sema_down(struct semaphore* sema) {
 
 	old_level = intr_disable();
 	while (sema->value == 0) {
-		list_insert_ordered(&sema->waiters, &thread_current()->elem, thread_compare_priority, NULL);
+		struct thread* curr = thread_current();
+
+		/* 기부로 우선순위가 바뀌면 thread_set_effective_priority()가
+			 heap 안에서 위치를 옮겨 준다. */
+		curr->wait_queue = &sema->waiters;
+		curr->wait_seq = next_wait_seq++;
+		heap_push(&sema->waiters, &curr->wait_elem);
 		thread_block();
 	}
 
@@ -111,10 +136,11 @@ sema_up(struct semaphore* sema) {
 	ASSERT(sema != NULL);
 
 	old_level = intr_disable();
-	if (!list_empty(&sema->waiters)) {
-		list_sort(&sema->waiters, thread_compare_priority, NULL);
-		thread_unblock(list_entry(list_pop_front(&sema->waiters),
-			struct thread, elem));
+	if (!heap_empty(&sema->waiters)) {
+		struct thread* t = heap_entry(heap_pop(&sema->waiters),
+			struct thread, wait_elem);
+		t->wait_queue = NULL;
+		thread_unblock(t);
 	}
 	sema->value++;
 
@@ -173,37 +199,146 @@ sema_test_helper(void* sema_) {
 	 onerous, it's a good sign that a semaphore should be used,
 	 instead of a lock. */
 void
-lock_init(struct lock* lock) {
+(lock_init)(struct lock* lock) {
 	ASSERT(lock != NULL);
 
 	lock->holder = NULL;
 	sema_init(&lock->semaphore, 1);
+#ifdef LOCKSTAT
+	lock->stat = NULL;
+#endif
 }
 
-bool thread_compare_donate_priority(const struct list_elem* a, const struct list_elem* b, void* aux UNUSED)
-{
-	struct thread* data_a = list_entry(a, struct thread, donation_elem);
-	struct thread* data_b = list_entry(b, struct thread, donation_elem);
-	return data_a->priority > data_b->priority;
+#ifdef LOCKSTAT
+/* Every lock_stat that has had a lock initialized, newest first. */
+static struct lock_stat* lockstat_list;
+
+/* Initializes LOCK, like lock_init(), and accounts its use in STAT.
+	 The lock_init() macro supplies a STAT per call site. */
+void
+lock_init_stat(struct lock* lock, struct lock_stat* stat) {
+	(lock_init)(lock);
+	lock->stat = stat;
+
+	enum intr_level old_level = intr_disable();
+	if (!stat->registered) {
+		stat->registered = true;
+		stat->next = lockstat_list;
+		lockstat_list = stat;
+	}
+	intr_set_level(old_level);
 }
 
-void donate_priority(void) {
-	// 'sema - waiters' 대기열에 들어가기 전에 우선순위 donation
-	struct thread* curr = thread_current();
+/* Stores in TOP up to MAX lock_stats with the most time spent waiting,
+	 most first, and returns how many it stored.  Sites that were never
+	 contended are left out. */
+size_t
+lockstat_top(struct lock_stat** top, size_t max) {
+	enum intr_level old_level = intr_disable();
+	size_t cnt = 0;
+
+	for (struct lock_stat* s = lockstat_list; s != NULL; s = s->next) {
+		size_t i;
+
+		if (s->contended == 0)
+			continue;
+		/* Insertion into TOP, which is short. */
+		for (i = cnt; i > 0 && top[i - 1]->wait_cycles < s->wait_cycles; i--)
+			if (i < max)
+				top[i] = top[i - 1];
+		if (i < max) {
+			top[i] = s;
+			if (cnt < max)
+				cnt++;
+		}
+	}
+	intr_set_level(old_level);
+	return cnt;
+}
+
+/* Prints the MAX lock sites with the most time spent waiting. */
+void
+lockstat_print(size_t max) {
+	struct lock_stat* top[16];
+	size_t cnt;
+
+	if (max > sizeof top / sizeof *top)
+		max = sizeof top / sizeof *top;
+	cnt = lockstat_top(top, max);
+	printf("Lock statistics: %zu contended lock site(s) shown\n", cnt);
+	for (size_t i = 0; i < cnt; i++) {
+		struct lock_stat* s = top[i];
+		printf("  %s (%s:%d): %llu acquired, %llu contended, %lld us waited, "
+			"%lld us max hold by %s\n",
+			s->name, s->file, s->line, (unsigned long long) s->acquired,
+			(unsigned long long) s->contended,
+			(long long) timer_tsc_to_ns(s->wait_cycles) / 1000,
+			(long long) timer_tsc_to_ns(s->max_hold_cycles) / 1000,
+			s->max_holder);
+	}
+}
+#endif
+
+/* Maximum number of lock holders a single donation is passed along
+	 (nested donation).  Set by kernel command-line option
+	 "-donate-depth=N". */
+int donate_depth_max = DONATE_DEPTH_DEFAULT;
+
+/* Returns the priority LOCK donates to its holder: that of its
+	 highest-priority waiter, or PRI_MIN - 1 if none.  The waiter heap
+	 keeps this at its top, so it costs O(1).  Interrupts must be off. */
+static int
+lock_donation(const struct lock* lock) {
+	const struct heap* waiters = &lock->semaphore.waiters;
+
+	if (heap_empty(waiters))
+		return PRI_MIN - 1;
+	return heap_entry(heap_top(waiters), struct thread, wait_elem)->priority;
+}
+
+/* Donates DONOR's priority along the chain of locks it waits on, to
+	 at most donate_depth_max holders. */
+static void
+donate_chain(struct thread* donor) {
+	struct thread* curr = donor;
+	int depth;
+
+	ASSERT(intr_get_level() == INTR_OFF);
 
 	// holder에게 우선순위 부여(중첩 고려)
-	while (curr->wait_on_lock != NULL) {
+	for (depth = 0; depth < donate_depth_max && curr->wait_on_lock != NULL; depth++) {
 		struct thread* holder = curr->wait_on_lock->holder;
 
-		if (curr->priority > holder->priority) {
-			holder->priority = curr->priority;
-			curr = holder;
-		}
-		else {
+		if (holder == NULL || curr->priority <= holder->priority)
 			break;
-		}
+
+		/* holder가 다른 lock을 기다리고 있다면 그 waiter heap 안의
+			 위치도 함께 갱신된다. */
+		thread_set_effective_priority(holder, curr->priority);
+		curr = holder;
+	}
+}
+
+/* Records that the current thread now holds LOCK, and picks up the
+	 donations of any threads still waiting for it. */
+static void
+lock_take(struct lock* lock) {
+	struct thread* curr = thread_current();
+	enum intr_level old_level = intr_disable();
+
+	lock->holder = curr;
+	list_push_back(&curr->held_locks, &lock->elem);
+#ifdef LOCKSTAT
+	if (lock->stat != NULL) {
+		lock->stat->acquired++;
+		lock->acquired_tsc = timer_tsc();
 	}
+#endif
+	if (!thread_mlfqs && lock_donation(lock) > curr->priority)
+		curr->priority = lock_donation(lock);
+	intr_set_level(old_level);
 }
+
 /* Acquires LOCK, sleeping until it becomes available if
 	 necessary.  The lock must not already be held by the current
 	 thread.
@@ -219,23 +354,30 @@ lock_acquire(struct lock* lock) {
 	ASSERT(!lock_held_by_current_thread(lock));
 
 	struct thread* curr = thread_current();
-
-	/* lock을 가진 스레드가 있다면 우선순위 기부 후, 대기 */
-	if (lock->holder) {
-		// holder의 donations에 현재 스레드 추가
-		list_insert_ordered(&lock->holder->donations, &curr->donation_elem, thread_compare_donate_priority, NULL);
-
-		// 현재 스레드가 실제로 기다리는 lock 추가
+	enum intr_level old_level = intr_disable();
+#ifdef LOCKSTAT
+	uint64_t wait_start = lock->holder != NULL ? timer_tsc() : 0;
+#endif
+
+	/* lock을 가진 스레드가 있다면 우선순위 기부 후, 대기 (mlfqs에서는 기부하지 않음).
+		 기부는 lock의 waiter heap에 들어가는 것만으로 기록되고,
+		 holder는 자기가 가진 lock들의 heap top만 보면 된다. */
+	if (lock->holder && !thread_mlfqs) {
 		curr->wait_on_lock = lock;
-
-		// 현재 스레드의 우선순위보다 낮은 중첩 스레드에게 우선순위 기부
-		donate_priority();
+		donate_chain(curr);
 	}
 	sema_down(&lock->semaphore);
 
 	/* lock을 가질 순서가 되면, lock을 가진다. */
 	curr->wait_on_lock = NULL;
-	lock->holder = curr;
+#ifdef LOCKSTAT
+	if (wait_start != 0 && lock->stat != NULL) {
+		lock->stat->contended++;
+		lock->stat->wait_cycles += timer_tsc() - wait_start;
+	}
+#endif
+	intr_set_level(old_level);
+	lock_take(lock);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -253,41 +395,35 @@ lock_try_acquire(struct lock* lock) {
 
 	success = sema_try_down(&lock->semaphore);
 	if (success)
-		lock->holder = thread_current();
+		lock_take(lock);
 	return success;
 }
 
-void remove_with_lock(struct lock* lock) {
-	// lock을 release 하는 시점에 해당 lock으로 나를 기다렸던 스레드의 우선순위 반환
-	// (각자 다른 lock으로 나를 기다릴 수 있기 때문에(다중), 해당 lock을 가진 thread만 삭제)
-
-	struct thread* curr = thread_current();
-	struct list_elem* d_elem = list_begin(&curr->donations);
-
-	while (d_elem != list_end(&curr->donations)) {
-		struct thread* t = list_entry(d_elem, struct thread, donation_elem);
-		if (lock == t->wait_on_lock) {
-			list_remove(&t->donation_elem); // 이제 관련 없는 스레드는 지워줌
-		}
-		d_elem = list_next(d_elem);
-	}
-}
-
+/* Recomputes the current thread's priority from its base priority and
+	 the top waiter of each lock and rwlock it holds, in O(number of held
+	 locks). */
 void refresh_priority(void) {
-	// 내가 가진 donations 중에 가장 높은 우선순위를 기부받음
 	struct thread* curr = thread_current();
-	curr->priority = curr->original_priority;
-
-	if (list_empty(&curr->donations)) {
-		return;
+	enum intr_level old_level = intr_disable();
+	struct list_elem* e;
+	int priority = curr->original_priority;
+
+	for (e = list_begin(&curr->held_locks); e != list_end(&curr->held_locks);
+		e = list_next(e)) {
+		int donated = lock_donation(list_entry(e, struct lock, elem));
+		if (donated > priority)
+			priority = donated;
 	}
 
-	list_sort(&curr->donations, thread_compare_donate_priority, NULL);
-
-	struct thread* max_thread = list_entry(list_front(&curr->donations), struct thread, donation_elem);
-	if (max_thread->priority > curr->priority) {
-		curr->priority = max_thread->priority;
+	// 내가 가진 rwlock을 기다리는 스레드들도 기부자다
+	for (int i = 0; i < RWLOCK_HOLD_MAX; i++) {
+		struct rwlock* rw = curr->rw_holds[i].rwlock;
+		if (rw != NULL && rwlock_waiter_priority(rw) > priority)
+			priority = rwlock_waiter_priority(rw);
 	}
+
+	curr->priority = priority;
+	intr_set_level(old_level);
 }
 
 /* Releases LOCK, which must be owned by the current thread.
@@ -301,14 +437,26 @@ lock_release(struct lock* lock) {
 	ASSERT(lock != NULL);
 	ASSERT(lock_held_by_current_thread(lock));
 
-	/* 해당 lock으로 기부받은 우선순위 삭제(중첩 처리) */
-	remove_with_lock(lock);
-
-	/* 현재 스레드 우선순위 재계산 */
-	refresh_priority();
-
 	/* lock을 해제함 */
+	enum intr_level old_level = intr_disable();
+#ifdef LOCKSTAT
+	if (lock->stat != NULL) {
+		uint64_t held = timer_tsc() - lock->acquired_tsc;
+		if (held > lock->stat->max_hold_cycles) {
+			lock->stat->max_hold_cycles = held;
+			strlcpy(lock->stat->max_holder, thread_name(),
+				sizeof lock->stat->max_holder);
+		}
+	}
+#endif
+	list_remove(&lock->elem);
 	lock->holder = NULL;
+
+	/* 해당 lock으로 기부받은 우선순위를 돌려주고 다시 계산한다. */
+	if (!thread_mlfqs)
+		refresh_priority();
+	intr_set_level(old_level);
+
 	sema_up(&lock->semaphore);
 }
 
@@ -322,12 +470,184 @@ lock_held_by_current_thread(const struct lock* lock) {
 	return lock->holder == thread_current();
 }
 
-/* One semaphore in a list. */
-struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
-	struct semaphore semaphore;         /* This semaphore. */
-	int priority;
-};
+/* Initializes RW as an unheld reader-writer lock.  Like locks,
+	 rwlocks are not recursive: a thread must not acquire an rwlock it
+	 already holds, in either mode. */
+void
+rwlock_init(struct rwlock* rw) {
+	ASSERT(rw != NULL);
+
+	rw->writer = NULL;
+	rw->reader_cnt = 0;
+	list_init(&rw->holders);
+	heap_init(&rw->read_waiters, sema_waiter_less, NULL);
+	heap_init(&rw->write_waiters, sema_waiter_less, NULL);
+}
+
+/* Returns the highest priority among threads waiting for RW, or
+	 PRI_MIN - 1 if there are none.  Interrupts must be off. */
+static int
+rwlock_waiter_priority(const struct rwlock* rw) {
+	int priority = PRI_MIN - 1;
+
+	if (!heap_empty(&rw->read_waiters))
+		priority = heap_entry(heap_top(&rw->read_waiters),
+			struct thread, wait_elem)->priority;
+	if (!heap_empty(&rw->write_waiters)) {
+		int w = heap_entry(heap_top(&rw->write_waiters),
+			struct thread, wait_elem)->priority;
+		if (w > priority)
+			priority = w;
+	}
+	return priority;
+}
+
+/* Records that the current thread holds RW. */
+static void
+rwlock_hold(struct rwlock* rw) {
+	struct thread* curr = thread_current();
+
+	for (int i = 0; i < RWLOCK_HOLD_MAX; i++) {
+		struct rwlock_hold* h = &curr->rw_holds[i];
+		if (h->rwlock == NULL) {
+			h->rwlock = rw;
+			h->thread = curr;
+			list_push_back(&rw->holders, &h->elem);
+			return;
+		}
+	}
+	PANIC("thread holds more than %d rwlocks", RWLOCK_HOLD_MAX);
+}
+
+/* Forgets the current thread's hold on RW. */
+static void
+rwlock_unhold(struct rwlock* rw) {
+	struct thread* curr = thread_current();
+
+	for (int i = 0; i < RWLOCK_HOLD_MAX; i++) {
+		struct rwlock_hold* h = &curr->rw_holds[i];
+		if (h->rwlock == rw) {
+			list_remove(&h->elem);
+			h->rwlock = NULL;
+			return;
+		}
+	}
+	NOT_REACHED();
+}
+
+/* Blocks the current thread in RW's waiter heap QUEUE, first donating
+	 its priority to every holder of RW.  Interrupts must be off. */
+static void
+rwlock_wait(struct rwlock* rw, struct heap* queue) {
+	struct thread* curr = thread_current();
+	struct list_elem* e;
+
+	if (!thread_mlfqs) {
+		for (e = list_begin(&rw->holders); e != list_end(&rw->holders);
+			e = list_next(e)) {
+			struct thread* holder = list_entry(e, struct rwlock_hold, elem)->thread;
+			if (curr->priority > holder->priority) {
+				thread_set_effective_priority(holder, curr->priority);
+				donate_chain(holder);
+			}
+		}
+	}
+
+	curr->wait_queue = queue;
+	curr->wait_seq = next_wait_seq++;
+	heap_push(queue, &curr->wait_elem);
+	thread_block();
+}
+
+/* Unblocks the first thread in QUEUE. */
+static void
+rwlock_wake(struct heap* queue) {
+	struct thread* t = heap_entry(heap_pop(queue), struct thread, wait_elem);
+
+	t->wait_queue = NULL;
+	thread_unblock(t);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or is
+	 waiting for it.
+
+	 This function may sleep, so it must not be called within an
+	 interrupt handler. */
+void
+rwlock_acquire_read(struct rwlock* rw) {
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+
+	old_level = intr_disable();
+	while (rw->writer != NULL || !heap_empty(&rw->write_waiters))
+		rwlock_wait(rw, &rw->read_waiters);
+	rw->reader_cnt++;
+	rwlock_hold(rw);
+	intr_set_level(old_level);
+}
+
+/* Acquires RW for writing, sleeping until no thread holds it.
+
+	 This function may sleep, so it must not be called within an
+	 interrupt handler. */
+void
+rwlock_acquire_write(struct rwlock* rw) {
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+
+	old_level = intr_disable();
+	while (rw->writer != NULL || rw->reader_cnt > 0)
+		rwlock_wait(rw, &rw->write_waiters);
+	rw->writer = thread_current();
+	rwlock_hold(rw);
+	intr_set_level(old_level);
+}
+
+/* Releases RW, which the current thread holds for reading.  The last
+	 reader out hands RW to the highest-priority waiting writer. */
+void
+rwlock_release_read(struct rwlock* rw) {
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(rw->reader_cnt > 0);
+
+	old_level = intr_disable();
+	rwlock_unhold(rw);
+	if (--rw->reader_cnt == 0 && !heap_empty(&rw->write_waiters))
+		rwlock_wake(&rw->write_waiters);
+	if (!thread_mlfqs)
+		refresh_priority();
+	intr_set_level(old_level);
+	thread_test_preemption();
+}
+
+/* Releases RW, which the current thread holds for writing.  A waiting
+	 writer goes next; otherwise every waiting reader is woken. */
+void
+rwlock_release_write(struct rwlock* rw) {
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(rw->writer == thread_current());
+
+	old_level = intr_disable();
+	rwlock_unhold(rw);
+	rw->writer = NULL;
+	if (!heap_empty(&rw->write_waiters))
+		rwlock_wake(&rw->write_waiters);
+	else
+		while (!heap_empty(&rw->read_waiters))
+			rwlock_wake(&rw->read_waiters);
+	if (!thread_mlfqs)
+		refresh_priority();
+	intr_set_level(old_level);
+	thread_test_preemption();
+}
 
 /* Initializes condition variable COND.  A condition variable
 	 allows one piece of code to signal a condition and cooperating
@@ -336,7 +656,7 @@ void
 cond_init(struct condition* cond) {
 	ASSERT(cond != NULL);
 
-	list_init(&cond->waiters);
+	heap_init(&cond->waiters, sema_waiter_less, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -359,30 +679,29 @@ cond_init(struct condition* cond) {
 	 interrupt handler.  This function may be called with
 	 interrupts disabled, but interrupts will be turned back on if
 	 we need to sleep. */
-bool sema_compare_priority(const struct list_elem* a, const struct list_elem* b,
-	void* aux UNUSED) {
-	struct semaphore_elem* sema_a = list_entry(a, struct semaphore_elem, elem);
-	struct semaphore_elem* sema_b = list_entry(b, struct semaphore_elem, elem);
-
-	return sema_a->priority > sema_b->priority;
-}
-
 void
 cond_wait(struct condition* cond, struct lock* lock) {
-	struct semaphore_elem waiter;
-	waiter.priority = thread_current()->priority;
+	struct thread* curr = thread_current();
+	enum intr_level old_level;
 
 	ASSERT(cond != NULL);
 	ASSERT(lock != NULL);
 	ASSERT(!intr_context());
 	ASSERT(lock_held_by_current_thread(lock));
 
-	sema_init(&waiter.semaphore, 0);
-	list_push_back(&cond->waiters, &waiter.elem);
-	// list_insert_ordered(&cond->waiters, &waiter.elem, sema_compare_priority, NULL);
+	/* sema_down()처럼 스레드를 직접 heap에 넣어 두면 기부로 우선순위가
+		 바뀔 때 thread_set_effective_priority()가 위치를 옮겨 준다. */
+	old_level = intr_disable();
+	curr->wait_queue = &cond->waiters;
+	curr->wait_seq = next_wait_seq++;
+	heap_push(&cond->waiters, &curr->wait_elem);
 
+	/* lock을 놓다가 선점될 수 있다.  그 사이에 signal을 받았다면
+		 wait_queue가 이미 비워져 있으므로 block하지 않는다. */
 	lock_release(lock);
-	sema_down(&waiter.semaphore);
+	if (curr->wait_queue != NULL)
+		thread_block();
+	intr_set_level(old_level);
 	lock_acquire(lock);
 }
 
@@ -408,13 +727,18 @@ cond_signal(struct condition* cond, struct lock* lock UNUSED) {
 	ASSERT(!intr_context());
 	ASSERT(lock_held_by_current_thread(lock));
 
-	if (!list_empty(&cond->waiters))
-	{
-		list_sort(&cond->waiters, sema_compare_priority, NULL);
-
-		sema_up(&list_entry(list_pop_front(&cond->waiters),
-			struct semaphore_elem, elem)->semaphore);
+	enum intr_level old_level = intr_disable();
+	if (!heap_empty(&cond->waiters)) {
+		struct thread* t = heap_entry(heap_pop(&cond->waiters),
+			struct thread, wait_elem);
+		t->wait_queue = NULL;
+		/* cond_wait()의 lock_release()에서 선점된 스레드는 아직 block하지
+			 않았고, 다시 돌면 스스로 wait_queue를 보고 지나간다. */
+		if (t->status == THREAD_BLOCKED)
+			thread_unblock(t);
 	}
+	intr_set_level(old_level);
+	thread_test_preemption();
 }
 /* Wakes up all threads, if any, waiting on COND (protected by
 	 LOCK).  LOCK must be held before calling this function.
@@ -427,6 +751,163 @@ cond_broadcast(struct condition* cond, struct lock* lock) {
 	ASSERT(cond != NULL);
 	ASSERT(lock != NULL);
 
-	while (!list_empty(&cond->waiters))
+	while (!heap_empty(&cond->waiters))
 		cond_signal(cond, lock);
 }
+
+/* One thread sleeping on a wait queue, on its own stack. */
+struct wait_queue_entry {
+	struct thread* thread;      /* Sleeping thread. */
+	bool exclusive;             /* Woken only one at a time? */
+	bool queued;                /* Still in the wait queue? */
+	struct list_elem elem;      /* Element in wait_queue's waiters. */
+};
+
+/* Initializes wait queue WQ as empty. */
+void
+wait_queue_init(struct wait_queue* wq) {
+	ASSERT(wq != NULL);
+
+	list_init(&wq->waiters);
+}
+
+/* Takes entry E off its wait queue and makes its thread ready.
+	 Interrupts must be off. */
+static void
+wait_entry_wake(struct wait_queue_entry* e) {
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	list_remove(&e->elem);
+	e->queued = false;
+	thread_unblock(e->thread);
+	if (intr_context() && thread_should_preempt(e->thread))
+		intr_yield_on_return();
+}
+
+/* Timer callback for wait_event_timeout(). */
+static void
+wait_entry_timeout(void* e_) {
+	struct wait_queue_entry* e = e_;
+
+	if (e->queued)
+		wait_entry_wake(e);
+}
+
+/* Sleeps on WQ until COND (AUX) returns true, or TICKS timer ticks
+	 have passed if TICKS >= 0.  Returns the last value of COND (AUX),
+	 so false means the wait timed out.  With EXCLUSIVE, wake_up() wakes
+	 this thread only if no exclusive waiter queued earlier is still
+	 waiting.
+
+	 COND is checked with interrupts off and before each sleep, so a
+	 wake_up() that follows a change to what COND reads cannot be
+	 missed.  This function may sleep, so it must not be called within
+	 an interrupt handler. */
+bool
+wait_event_timeout(struct wait_queue* wq, wait_pred* cond, void* aux,
+	bool exclusive, int64_t ticks) {
+	struct wait_queue_entry e;
+	struct timer_event timeout;
+	enum intr_level old_level;
+	bool done;
+
+	ASSERT(wq != NULL);
+	ASSERT(cond != NULL);
+	ASSERT(!intr_context());
+
+	e.thread = thread_current();
+	e.exclusive = exclusive;
+	e.queued = false;
+	timer_event_init(&timeout, wait_entry_timeout, &e);
+
+	old_level = intr_disable();
+	e.thread->wait_entry = &e;
+	if (ticks > 0)
+		timer_event_add(&timeout, timer_ticks() + ticks);
+	while (!(done = cond(aux))) {
+		if (ticks >= 0 && !timeout.pending)
+			break;
+		/* 공유 대기자는 앞에, 배타 대기자는 뒤에 줄을 세운다. */
+		if (exclusive)
+			list_push_back(&wq->waiters, &e.elem);
+		else
+			list_push_front(&wq->waiters, &e.elem);
+		e.queued = true;
+		thread_block();
+	}
+	if (e.queued) {
+		list_remove(&e.elem);
+		e.queued = false;
+	}
+	e.thread->wait_entry = NULL;
+	timer_event_cancel(&timeout);
+	intr_set_level(old_level);
+	return done;
+}
+
+/* Sleeps on WQ until COND (AUX) returns true. */
+void
+wait_event(struct wait_queue* wq, wait_pred* cond, void* aux) {
+	wait_event_timeout(wq, cond, aux, false, -1);
+}
+
+/* Sleeps on WQ as an exclusive waiter until COND (AUX) returns true. */
+void
+wait_event_exclusive(struct wait_queue* wq, wait_pred* cond, void* aux) {
+	wait_event_timeout(wq, cond, aux, true, -1);
+}
+
+/* Wakes every shared waiter on WQ and the exclusive waiter that has
+	 waited longest.  Returns the number of threads woken. */
+int
+wake_up(struct wait_queue* wq) {
+	enum intr_level old_level = intr_disable();
+	int woken = 0;
+
+	while (!list_empty(&wq->waiters)) {
+		struct wait_queue_entry* e = list_entry(list_front(&wq->waiters),
+			struct wait_queue_entry, elem);
+		bool exclusive = e->exclusive;
+
+		wait_entry_wake(e);
+		woken++;
+		if (exclusive)
+			break;
+	}
+	if (!intr_context())
+		thread_test_preemption();
+	intr_set_level(old_level);
+	return woken;
+}
+
+/* Wakes T if it sleeps in wait_event() or one of its variants, so that
+	 it checks its predicate again; it goes back to sleep if that still
+	 fails.  Does nothing if T is not in such a wait.  Used to break a
+	 thread out of a wait whose predicate also watches for its process
+	 exiting. */
+void
+wait_event_kick(struct thread* t) {
+	enum intr_level old_level = intr_disable();
+
+	if (t->wait_entry != NULL && t->wait_entry->queued)
+		wait_entry_wake(t->wait_entry);
+	intr_set_level(old_level);
+}
+
+/* Wakes every waiter on WQ, shared and exclusive.  Returns the
+	 number of threads woken. */
+int
+wake_up_all(struct wait_queue* wq) {
+	enum intr_level old_level = intr_disable();
+	int woken = 0;
+
+	while (!list_empty(&wq->waiters)) {
+		wait_entry_wake(list_entry(list_front(&wq->waiters),
+			struct wait_queue_entry, elem));
+		woken++;
+	}
+	if (!intr_context())
+		thread_test_preemption();
+	intr_set_level(old_level);
+	return woken;
+}
@@ -4,6 +4,8 @@
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/rcu.h"
+#include "threads/trace.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include <debug.h>
@@ -12,6 +14,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/malloc.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -26,9 +29,57 @@
      Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-     /* List of processes in THREAD_READY state, that is, processes
-         that are ready to run but not actually running. */
-static struct list ready_list;
+     /* Run queue of processes in THREAD_READY state, that is, processes
+         that are ready to run but not actually running.  One FIFO list per
+         priority, and a bitmap whose bit P is set when ready_list[P] is
+         non-empty, so that enqueue, dequeue and finding the highest ready
+         priority are all O(1).  PRI_MAX must stay below 64.  Only the boot
+         processor runs threads (see threads/cpu.c), so turning interrupts
+         off protects it. */
+static struct list ready_list[PRI_MAX + 1];
+static uint64_t ready_bitmap;
+static int ready_cnt;         /* # of threads in ready_list. */
+
+/* CFS run queue: ready threads ordered by vruntime, so the thread that
+   has received the least weighted CPU time is always leftmost.  Used
+   instead of ready_list when thread_cfs. */
+static struct rb_tree cfs_tree;
+static uint64_t cfs_min_vruntime;      /* Monotonic floor of vruntime. */
+static uint64_t cfs_load;              /* Total weight of cfs_tree. */
+
+/* List of all live threads, for the MLFQS once-a-second recompute. */
+static struct list all_list;
+
+/* MLFQS system load average. */
+static fixed_t load_avg;
+
+/* Ends the running thread's CFS slice. */
+static struct hrtimer cfs_slice_timer;
+
+/* CFS tunables, in nanoseconds.  Every runnable thread should get the
+   CPU once per CFS_LATENCY_NS, unless that would make slices shorter
+   than CFS_MIN_GRANULARITY_NS.  A woken thread preempts only if it is
+   more than CFS_WAKEUP_GRANULARITY_NS behind the running one. */
+#define CFS_LATENCY_NS 6000000
+#define CFS_MIN_GRANULARITY_NS 750000
+#define CFS_WAKEUP_GRANULARITY_NS 1000000
+#define CFS_NR_LATENCY (CFS_LATENCY_NS / CFS_MIN_GRANULARITY_NS)
+
+/* Weight of nice 0.  vruntime advances at wall-clock rate for it. */
+#define NICE_0_WEIGHT 1024
+
+/* Weight for nice -20 ... 19.  Each step is about 1.25x, so one nice
+   level is roughly a 10% CPU share between two competing threads. */
+static const uint32_t cfs_prio_to_weight[40] = {
+  88761, 71755, 56483, 46273, 36291,
+  29154, 23254, 18705, 14949, 11916,
+  9548, 7620, 6100, 4904, 3906,
+  3121, 2501, 1991, 1586, 1277,
+  1024, 820, 655, 526, 423,
+  335, 272, 215, 172, 137,
+  110, 87, 70, 56, 45,
+  36, 29, 23, 18, 15,
+};
 
 /* Idle thread. */
 static struct thread* idle_thread;
@@ -42,6 +93,14 @@ static struct lock tid_lock;
 /* Thread destruction requests */
 static struct list destruction_req;
 
+/* Pages of dead threads, kept for reuse by thread_create() so that
+   spawning a thread needs neither palloc nor zeroing a whole page.
+   Only init_thread() clears the struct thread at the bottom; the
+   stack above it is left as it was.  Accessed with interrupts off. */
+#define THREAD_CACHE_MAX 16
+static struct list thread_cache;
+static size_t thread_cache_cnt;
+
 /* Statistics. */
 static long long idle_ticks;   /* # of timer ticks spent idle. */
 static long long kernel_ticks; /* # of timer ticks in kernel threads. */
@@ -56,12 +115,27 @@ If true, use multi-level feedback queue
 scheduler. Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, use the completely fair scheduler.  Controlled by kernel
+   command-line option "-cfs". */
+bool thread_cfs;
+
 static void kernel_thread(thread_func*, void* aux);
+static void switch_entry(void);
+void switch_threads(uint64_t* cur_rsp, uint64_t next_rsp);
 
 static void idle(void* aux UNUSED);
 static struct thread* next_thread_to_run(void);
 static void init_thread(struct thread*, const char* name, int priority);
+static void mlfqs_tick(struct thread* t);
+static uint32_t cfs_weight(const struct thread* t);
+static void cfs_update_curr(void);
+static void cfs_start_slice(struct thread* t);
+static void cfs_slice_expired(void* aux UNUSED);
+static bool cfs_less(const struct rb_node* a, const struct rb_node* b,
+  void* aux UNUSED);
 static void do_schedule(int status);
+static struct thread* thread_page_get(void);
+static void thread_page_put(struct thread*);
 static void schedule(void);
 static tid_t allocate_tid(void);
 
@@ -108,8 +182,14 @@ thread_init(void) {
 
   /* Init the globla thread context */
   lock_init(&tid_lock);
-  list_init(&ready_list);
+  for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+    list_init(&ready_list[pri]);
+  ready_bitmap = 0;
+  rb_init(&cfs_tree, cfs_less, NULL);
+  hrtimer_init(&cfs_slice_timer, cfs_slice_expired, NULL);
+  list_init(&all_list);
   list_init(&destruction_req);
+  list_init(&thread_cache);
 
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread();
@@ -151,6 +231,19 @@ thread_tick(void) {
   else
     kernel_ticks++;
 
+  rcu_tick();
+
+  if (thread_mlfqs)
+    mlfqs_tick(t);
+
+  /* Under CFS the slice timer ends time slices; fall back to ticks
+     only until the TSC is calibrated. */
+  if (thread_cfs) {
+    cfs_update_curr();
+    if (cfs_slice_timer.pending)
+      return;
+  }
+
   /* Enforce preemption. */
   if (++thread_ticks >= TIME_SLICE){
     intr_yield_on_return();
@@ -164,22 +257,105 @@ thread_print_stats(void) {
     idle_ticks, kernel_ticks, user_ticks);
 }
 
-/* ready_list 우선순위 정렬을 위한 서브 함수 */
-bool thread_compare_priority(const struct list_elem* a, const struct list_elem* b,
-  void* aux UNUSED) {
-  struct thread* data_a = list_entry(a, struct thread, elem);
-  struct thread* data_b = list_entry(b, struct thread, elem);
-  return data_a->priority > data_b->priority;
+/* Appends T to the run queue for its priority, or inserts it in the CFS
+   tree by vruntime.  Interrupts must be off. */
+static void
+ready_push(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (thread_cfs) {
+    rb_insert(&cfs_tree, &t->cfs_node);
+    cfs_load += cfs_weight(t);
+  }
+  else {
+    list_push_back(&ready_list[t->priority], &t->elem);
+    ready_bitmap |= 1ULL << t->priority;
+  }
+  ready_cnt++;
+}
+
+/* Removes ready thread T from the run queue.  Interrupts must be off. */
+static void
+ready_remove(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (thread_cfs) {
+    rb_remove(&cfs_tree, &t->cfs_node);
+    cfs_load -= cfs_weight(t);
+  }
+  else {
+    list_remove(&t->elem);
+    if (list_empty(&ready_list[t->priority]))
+      ready_bitmap &= ~(1ULL << t->priority);
+  }
+  ready_cnt--;
+}
+
+/* Returns the highest priority among ready threads, or -1 if there are
+   none. */
+static int
+ready_max_priority(void) {
+  return ready_bitmap != 0 ? 63 - __builtin_clzll(ready_bitmap) : -1;
+}
+
+/* Sets T's effective priority to PRIORITY, moving T to the tail of its
+   new run queue if it is ready (under CFS, reweighting it), or to its
+   new place among the waiters if it waits on a semaphore, rwlock or
+   condition variable.  Use this instead of assigning
+   t->priority for any thread other than the running one. */
+void
+thread_set_effective_priority(struct thread* t, int priority) {
+  enum intr_level old_level = intr_disable();
+
+  ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+  if (t->status == THREAD_READY && t->priority != priority) {
+    ready_remove(t);
+    t->priority = priority;
+    ready_push(t);
+  }
+  else
+    t->priority = priority;
+  /* cond_wait()는 block하기 전에 heap에 들어가므로 상태와 상관없이
+     waiter heap 안의 위치를 옮긴다. */
+  if (t->wait_queue != NULL)
+    heap_update(t->wait_queue, &t->wait_elem);
+  intr_set_level(old_level);
+}
+
+/* Returns true if ready thread T should preempt the running thread:
+   under CFS if T is far enough behind it in vruntime, otherwise if T has
+   higher priority.  Interrupts must be off. */
+bool
+thread_should_preempt(struct thread* t) {
+  struct thread* curr = thread_current();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (!thread_cfs)
+    return t->priority > curr->priority;
+  if (curr == idle_thread)
+    return true;
+  cfs_update_curr();
+  return t->vruntime + CFS_WAKEUP_GRANULARITY_NS < curr->vruntime;
 }
 
+/* Yields if a ready thread should run before the current one. */
 void
 thread_test_preemption(void)
 {
-  if (!list_empty(&ready_list) &&
-    thread_current()->priority <
-    list_entry(list_front(&ready_list), struct thread, elem)->priority)
-    if(!intr_context())
-      thread_yield();
+  enum intr_level old_level;
+  bool preempt;
+
+  if (intr_context())
+    return;
+
+  old_level = intr_disable();
+  if (thread_cfs)
+    preempt = !rb_empty(&cfs_tree)
+      && thread_should_preempt(rb_entry(rb_min(&cfs_tree), struct thread, cfs_node));
+  else
+    preempt = thread_current()->priority < ready_max_priority();
+  intr_set_level(old_level);
+
+  if (preempt)
+    thread_yield();
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -207,13 +383,18 @@ thread_create(const char* name, int priority,
   ASSERT(function != NULL);
   
   /* Allocate thread. */
-  t = palloc_get_page(PAL_ZERO);
+  t = thread_page_get();
   if (t == NULL)
     return TID_ERROR;
   
   /* Initialize thread. */
   init_thread(t, name, priority);
   tid = t->tid = allocate_tid();
+  if (trace_enabled) {
+    uint64_t name8 = 0;
+    memcpy(&name8, t->name, sizeof name8);
+    trace(TRACE_THREAD_NEW, tid, name8);
+  }
   
   /* child list init */
   lock_init(&t->childlist_lock);
@@ -231,8 +412,7 @@ thread_create(const char* name, int priority,
 
     t->child_status = ch_st;
     t->child_status->tid = tid;
-    sema_init(&t->child_status->sema_fork, 0);
-    sema_init(&t->child_status->sema_wait, 0);
+    wait_queue_init(&t->child_status->wq);
     
     //printf("create tid: %d\n", t->child_status->tid);
   }
@@ -259,6 +439,16 @@ thread_create(const char* name, int priority,
   t->tf.cs = SEL_KCSEG;
   t->tf.eflags = FLAG_IF;
 
+  /* Stack for the first switch_threads() to T: six callee-saved
+     registers, then switch_entry() as the return address, then a null
+     return address for switch_entry(), which keeps the stack aligned
+     as after a call. */
+  uint64_t* sp = (uint64_t*)((uint8_t*)t + PGSIZE);
+  *--sp = 0;
+  *--sp = (uint64_t)switch_entry;
+  sp -= 6;
+  t->ctx_rsp = (uint64_t)sp;
+
 
 
   /* Add to run queue. */
@@ -298,9 +488,17 @@ thread_unblock(struct thread* t) {
 
   old_level = intr_disable();
   ASSERT(t->status == THREAD_BLOCKED);
-  // list_push_back(&ready_list, &t->elem);
-  list_insert_ordered(&ready_list, &t->elem, thread_compare_priority, NULL);
+  if (thread_cfs) {
+    /* A thread that slept keeps at most half a latency period of
+       credit, so it runs soon but cannot monopolize the CPU. */
+    uint64_t floor = cfs_min_vruntime > CFS_LATENCY_NS / 2
+      ? cfs_min_vruntime - CFS_LATENCY_NS / 2 : 0;
+    if (t->vruntime < floor)
+      t->vruntime = floor;
+  }
+  ready_push(t);
   t->status = THREAD_READY;
+  trace(TRACE_WAKEUP, t->tid, t->priority);
 
   intr_set_level(old_level);
 }
@@ -348,6 +546,7 @@ thread_exit(void) {
   /* Just set our status to dying and schedule another process.
      We will be destroyed during the call to schedule_tail(). */
   intr_disable();
+  list_remove(&thread_current()->all_elem);
   do_schedule(THREAD_DYING);
   NOT_REACHED();
 }
@@ -362,9 +561,11 @@ thread_yield(void) {
   ASSERT(!intr_context());
 
   old_level = intr_disable();
-  if (curr != idle_thread)
-    // list_push_back(&ready_list, &curr->elem);
-    list_insert_ordered(&ready_list, &curr->elem, thread_compare_priority, NULL);
+  if (curr != idle_thread) {
+    if (thread_cfs)
+      cfs_update_curr();
+    ready_push(curr);
+  }
 
   do_schedule(THREAD_READY);
   intr_set_level(old_level);
@@ -373,6 +574,10 @@ thread_yield(void) {
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void
 thread_set_priority(int new_priority) {
+  /* mlfqs에서는 스케줄러가 우선순위를 정한다. */
+  if (thread_mlfqs)
+    return;
+
   // 우선순위가 낮아졌다면 우선순위가 높은 쓰레드에게 넘김
   thread_current()->original_priority = new_priority; // donation을 위한 추가
   refresh_priority(); // 변경된 우선순위 반영하여 다시 donation
@@ -385,31 +590,192 @@ thread_get_priority(void) {
   return thread_current()->priority;
 }
 
+/* Returns T's MLFQS priority,
+   PRI_MAX - (recent_cpu / 4) - (nice * 2), clamped to the valid range. */
+static int
+mlfqs_priority(const struct thread* t) {
+  int priority = PRI_MAX - fp_to_int(fp_div_int(t->recent_cpu, 4)) - t->nice * 2;
+
+  if (priority < PRI_MIN)
+    return PRI_MIN;
+  if (priority > PRI_MAX)
+    return PRI_MAX;
+  return priority;
+}
+
+/* Once a second: updates load_avg, then decays every thread's recent_cpu
+   and recomputes its priority.  The decay coefficient is the same for
+   all threads, so it is computed once. */
+static void
+mlfqs_recompute_all(void) {
+  struct list_elem* e;
+  int ready_threads = ready_cnt + (thread_current() != idle_thread);
+  fixed_t decay;
+
+  load_avg = fp_add(fp_div_int(fp_mul_int(load_avg, 59), 60),
+    fp_div_int(int_to_fp(ready_threads), 60));
+  decay = fp_div(fp_mul_int(load_avg, 2), fp_add_int(fp_mul_int(load_avg, 2), 1));
+
+  for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
+    struct thread* t = list_entry(e, struct thread, all_elem);
+    if (t == idle_thread)
+      continue;
+    t->recent_cpu = fp_add_int(fp_mul(decay, t->recent_cpu), t->nice);
+    thread_set_effective_priority(t, mlfqs_priority(t));
+  }
+}
+
+/* MLFQS bookkeeping for timer tick, T being the running thread.  Between
+   the once-a-second recomputes only the running thread's recent_cpu
+   changes, so only its priority needs updating every fourth tick. */
+static void
+mlfqs_tick(struct thread* t) {
+  int64_t ticks = timer_ticks();
+
+  if (t != idle_thread)
+    t->recent_cpu = fp_add_int(t->recent_cpu, 1);
+
+  if (ticks % TIMER_FREQ == 0)
+    mlfqs_recompute_all();
+  else if (ticks % 4 == 0 && t != idle_thread)
+    t->priority = mlfqs_priority(t);
+
+  if (ticks % 4 == 0 && t->priority < ready_max_priority())
+    intr_yield_on_return();
+}
+
 /* Sets the current thread's nice value to NICE. */
 void
-thread_set_nice(int nice UNUSED) {
-  /* TODO: Your implementation goes here */
+thread_set_nice(int nice) {
+  struct thread* curr = thread_current();
+  enum intr_level old_level = intr_disable();
+
+  /* Under CFS nice only changes the weight, which the running thread's
+     vruntime picks up from its next charge. */
+  if (thread_cfs)
+    cfs_update_curr();
+  curr->nice = nice;
+  if (thread_mlfqs)
+    curr->priority = mlfqs_priority(curr);
+  intr_set_level(old_level);
+  thread_test_preemption();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice(void) {
-  /* TODO: Your implementation goes here */
-  return 0;
+  return thread_current()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg(void) {
-  /* TODO: Your implementation goes here */
-  return 0;
+  enum intr_level old_level = intr_disable();
+  int load = fp_to_int_round(fp_mul_int(load_avg, 100));
+  intr_set_level(old_level);
+  return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu(void) {
-  /* TODO: Your implementation goes here */
-  return 0;
+  enum intr_level old_level = intr_disable();
+  int recent = fp_to_int_round(fp_mul_int(thread_current()->recent_cpu, 100));
+  intr_set_level(old_level);
+  return recent;
+}
+
+/* Returns T's CFS weight.  Priority maps linearly onto nice, with
+   PRI_DEFAULT as nice 0 and PRI_MAX as nice -20; T's own nice value is
+   added on top. */
+static uint32_t
+cfs_weight(const struct thread* t) {
+  int nice = (PRI_DEFAULT - t->priority) * 20 / (PRI_MAX - PRI_DEFAULT) + t->nice;
+
+  if (nice < NICE_MIN)
+    nice = NICE_MIN;
+  if (nice > NICE_MAX)
+    nice = NICE_MAX;
+  return cfs_prio_to_weight[nice - NICE_MIN];
+}
+
+/* Orders CFS threads by vruntime. */
+static bool
+cfs_less(const struct rb_node* a, const struct rb_node* b, void* aux UNUSED) {
+  return rb_entry(a, struct thread, cfs_node)->vruntime
+    < rb_entry(b, struct thread, cfs_node)->vruntime;
+}
+
+/* Advances cfs_min_vruntime to the smallest vruntime among the running
+   and ready threads.  It never moves backward, so that threads placed
+   relative to it cannot gain credit from a thread leaving. */
+static void
+cfs_update_min_vruntime(void) {
+  struct thread* curr = running_thread();
+  uint64_t v = cfs_min_vruntime;
+  bool any = false;
+
+  if (curr != idle_thread && curr->status == THREAD_RUNNING) {
+    v = curr->vruntime;
+    any = true;
+  }
+  if (!rb_empty(&cfs_tree)) {
+    uint64_t left = rb_entry(rb_min(&cfs_tree), struct thread, cfs_node)->vruntime;
+    if (!any || left < v)
+      v = left;
+    any = true;
+  }
+  if (any && v > cfs_min_vruntime)
+    cfs_min_vruntime = v;
+}
+
+/* Charges the running thread for the time since it was last charged,
+   scaled by NICE_0_WEIGHT / weight.  Interrupts must be off. */
+static void
+cfs_update_curr(void) {
+  struct thread* curr = running_thread();
+  uint64_t now = timer_tsc();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (curr == idle_thread)
+    return;
+  curr->vruntime += (uint64_t)timer_tsc_to_ns(now - curr->exec_start)
+    * NICE_0_WEIGHT / cfs_weight(curr);
+  curr->exec_start = now;
+  cfs_update_min_vruntime();
+}
+
+/* Starts a time slice for T, about to run: T's share of the scheduling
+   period by weight, but no shorter than CFS_MIN_GRANULARITY_NS.  The
+   period grows with the number of runnable threads past
+   CFS_NR_LATENCY. */
+static void
+cfs_start_slice(struct thread* t) {
+  uint64_t period, load, slice;
+  int nr_running = ready_cnt + 1;
+
+  t->exec_start = timer_tsc();
+  hrtimer_cancel(&cfs_slice_timer);
+  if (t == idle_thread || !hrtimer_available())
+    return;
+
+  period = nr_running > CFS_NR_LATENCY
+    ? (uint64_t)nr_running * CFS_MIN_GRANULARITY_NS : CFS_LATENCY_NS;
+  load = cfs_load + cfs_weight(t);
+  slice = period * cfs_weight(t) / load;
+  if (slice < CFS_MIN_GRANULARITY_NS)
+    slice = CFS_MIN_GRANULARITY_NS;
+  hrtimer_start(&cfs_slice_timer, slice);
+}
+
+/* Slice timer callback.  With nobody else ready the running thread just
+   gets another slice. */
+static void
+cfs_slice_expired(void* aux UNUSED) {
+  if (rb_empty(&cfs_tree))
+    cfs_start_slice(thread_current());
+  else
+    intr_yield_on_return();
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -433,6 +799,10 @@ idle(void* idle_started_ UNUSED) {
     intr_disable();
     thread_block();
 
+    /* Nothing to run: stop the periodic tick until the next timer
+       event, then halt. */
+    timer_idle_enter();
+
     /* Re-enable interrupts and wait for the next one.
 
        The `sti' instruction disables interrupts until the
@@ -474,9 +844,30 @@ init_thread(struct thread* t, const char* name, int priority) {
   t->priority = priority;
   t->original_priority = priority;
   t->wait_on_lock = NULL;
-  list_init(&t->donations);
+  list_init(&t->held_locks);
+  t->leader = t;
+  list_init(&t->uthread_list);
+  sema_init(&t->uthread_sema, 0);
   t->magic = THREAD_MAGIC;
 
+  /* 새 스레드는 만든 스레드의 nice와 recent_cpu를 물려받는다. */
+  if (thread_mlfqs) {
+    struct thread* parent = running_thread();
+    if (parent != t) {
+      t->nice = parent->nice;
+      t->recent_cpu = parent->recent_cpu;
+    }
+    t->priority = t->original_priority = mlfqs_priority(t);
+  }
+
+  /* 새 스레드는 현재 min_vruntime에서 시작한다. */
+  t->vruntime = cfs_min_vruntime;
+  t->exec_start = timer_tsc();
+
+  enum intr_level old_level = intr_disable();
+  list_push_back(&all_list, &t->all_elem);
+  intr_set_level(old_level);
+
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
@@ -486,10 +877,21 @@ init_thread(struct thread* t, const char* name, int priority) {
    idle_thread. */
 static struct thread*
 next_thread_to_run(void) {
-  if (list_empty(&ready_list))
+  int pri = ready_max_priority();
+  struct thread* t;
+
+  if (thread_cfs) {
+    if (rb_empty(&cfs_tree))
+      return idle_thread;
+    t = rb_entry(rb_min(&cfs_tree), struct thread, cfs_node);
+    ready_remove(t);
+    return t;
+  }
+  if (pri < 0)
     return idle_thread;
-  else
-    return list_entry(list_pop_front(&ready_list), struct thread, elem);
+  t = list_entry(list_front(&ready_list[pri]), struct thread, elem);
+  ready_remove(t);
+  return t;
 }
 
 /* Use iretq to launch the thread */
@@ -521,73 +923,59 @@ do_iret(struct intr_frame* tf) {
     : : "g" ((uint64_t)tf) : "memory");
 }
 
-/* Switching the thread by activating the new thread's page
-tables, and, if the previous thread is dying,destroying it.
+/* Switches from the running thread to TH.
 
-   At this function's invocation, we just switched from thread
-   PREV, the new thread is already running, and interrupts are
-   still disabled.
+   At this function's invocation, interrupts are disabled, and they
+   are still disabled when the switched-out thread later returns from
+   it.  Only the callee-saved registers and the stack pointer change
+   hands (see switch.S): the switch happens between two kernel stacks,
+   so unlike do_iret() it needs no intr_frame, segment reloads or
+   iretq.  User mode is still entered and left through the intr_frame
+   on the kernel stack, by intr_exit and do_iret().
 
    It's not safe to call printf() until the thread switch is
-   complete.  In practice that means that printf()s should be
-   added at the end of the function. */
+   complete. */
 static void
 thread_launch(struct thread* th) {
-  uint64_t tf_cur = (uint64_t)&running_thread()->tf;
-  uint64_t tf = (uint64_t)&th->tf;
   ASSERT(intr_get_level() == INTR_OFF);
+  switch_threads(&running_thread()->ctx_rsp, th->ctx_rsp);
+}
 
-  /* The main switching logic.
-   * We first restore the whole execution context into the intr_frame
-   * and then switching to the next thread by calling do_iret.
-   * Note that, we SHOULD NOT use any stack from here
-   * until switching is done. */
-  __asm __volatile(
-  /* Store registers that will be used. */
-  "push %%rax\n"
-    "push %%rbx\n"
-    "push %%rcx\n"
-    /* Fetch input once */
-    "movq %0, %%rax\n"
-    "movq %1, %%rcx\n"
-    "movq %%r15, 0(%%rax)\n"
-    "movq %%r14, 8(%%rax)\n"
-    "movq %%r13, 16(%%rax)\n"
-    "movq %%r12, 24(%%rax)\n"
-    "movq %%r11, 32(%%rax)\n"
-    "movq %%r10, 40(%%rax)\n"
-    "movq %%r9, 48(%%rax)\n"
-    "movq %%r8, 56(%%rax)\n"
-    "movq %%rsi, 64(%%rax)\n"
-    "movq %%rdi, 72(%%rax)\n"
-    "movq %%rbp, 80(%%rax)\n"
-    "movq %%rdx, 88(%%rax)\n"
-    "pop %%rbx\n"              // Saved rcx
-    "movq %%rbx, 96(%%rax)\n"
-    "pop %%rbx\n"              // Saved rbx
-    "movq %%rbx, 104(%%rax)\n"
-    "pop %%rbx\n"              // Saved rax
-    "movq %%rbx, 112(%%rax)\n"
-    "addq $120, %%rax\n"
-    "movw %%es, (%%rax)\n"
-    "movw %%ds, 8(%%rax)\n"
-    "addq $32, %%rax\n"
-    "call __next\n"         // read the current rip.
-    "__next:\n"
-    "pop %%rbx\n"
-    "addq $(out_iret -  __next), %%rbx\n"
-    "movq %%rbx, 0(%%rax)\n" // rip
-    "movw %%cs, 8(%%rax)\n"  // cs
-    "pushfq\n"
-    "popq %%rbx\n"
-    "mov %%rbx, 16(%%rax)\n" // eflags
-    "mov %%rsp, 24(%%rax)\n" // rsp
-    "movw %%ss, 32(%%rax)\n"
-    "mov %%rcx, %%rdi\n"
-    "call do_iret\n"
-    "out_iret:\n"
-    : : "g"(tf_cur), "g" (tf) : "memory"
-    );
+/* First code run by a new thread, which switch_threads() "returns"
+   into.  Enters the thread through the intr_frame that
+   thread_create() prepared. */
+static void
+switch_entry(void) {
+  do_iret(&running_thread()->tf);
+}
+
+/* Returns a page for a new thread, from thread_cache if possible.
+   Its contents are undefined; init_thread() sets up the header. */
+static struct thread*
+thread_page_get(void) {
+  struct thread* t = NULL;
+  enum intr_level old_level = intr_disable();
+
+  if (!list_empty(&thread_cache)) {
+    t = list_entry(list_pop_front(&thread_cache), struct thread, elem);
+    thread_cache_cnt--;
+  }
+  intr_set_level(old_level);
+  return t != NULL ? t : palloc_get_page(0);
+}
+
+/* Releases dead thread T's page into thread_cache, or to the page
+   allocator if the cache is full.  Interrupts must be off. */
+static void
+thread_page_put(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (thread_cache_cnt < THREAD_CACHE_MAX) {
+    list_push_front(&thread_cache, &t->elem);
+    thread_cache_cnt++;
+  }
+  else
+    palloc_free_page(t);
 }
 
 /* Schedules a new process. At entry, interrupts must be off.
@@ -601,7 +989,7 @@ do_schedule(int status) {
   while (!list_empty(&destruction_req)) {
     struct thread* victim =
       list_entry(list_pop_front(&destruction_req), struct thread, elem);
-    palloc_free_page(victim);
+    thread_page_put(victim);
   }
   thread_current()->status = status;
   schedule();
@@ -613,7 +1001,14 @@ schedule(void) {
   enum intr_level old_level;
   old_level = intr_disable();
   struct thread* curr = running_thread();
-  struct thread* next = next_thread_to_run();
+  struct thread* next;
+
+  /* 떠나는 스레드가 쓴 시간을 vruntime에 더한다.  READY면
+     thread_yield()가 cfs_tree에 넣기 전에 이미 더했고, 트리 안에 있는
+     노드의 key를 바꾸면 안 된다. */
+  if (thread_cfs && curr->status != THREAD_READY)
+    cfs_update_curr();
+  next = next_thread_to_run();
 
   ASSERT(intr_get_level() == INTR_OFF);
   ASSERT(curr->status != THREAD_RUNNING);
@@ -623,6 +1018,8 @@ schedule(void) {
 
   /* Start new time slice. */
   thread_ticks = 0;
+  if (thread_cfs)
+    cfs_start_slice(next);
 
   intr_set_level(old_level);
 #ifdef USERPROG
@@ -643,6 +1040,9 @@ schedule(void) {
       list_push_back(&destruction_req, &curr->elem);
     }
 
+    rcu_note_context_switch(curr);
+    trace(TRACE_SWITCH, curr->tid, next->tid);
+
     /* Before switching the thread, we first save the information
      * of current running. */
     thread_launch(next);
@@ -661,11 +1061,3 @@ allocate_tid(void) {
 
   return tid;
 }
-
-bool earlier_wake_up(const struct list_elem* a, const struct list_elem* b, void* aux UNUSED)
-{
-  struct thread* thread_a = list_entry(a, struct thread, elem);
-  struct thread* thread_b = list_entry(b, struct thread, elem);
-
-  return thread_a->wakeup_tick < thread_b->wakeup_tick;
-}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* One record.  32 bytes, so that a page holds a whole number. */
+struct trace_record {
+	uint64_t tsc;               /* timer_tsc() when emitted. */
+	uint32_t event;             /* enum trace_event. */
+	uint32_t unused;
+	uint64_t arg[2];
+};
+
+/* Records per CPU, in TRACE_PAGES pages.  When a ring is full the
+   oldest records are overwritten. */
+#define TRACE_PAGES 8
+#define TRACE_RECORDS (TRACE_PAGES * PGSIZE / sizeof (struct trace_record))
+
+/* A CPU's ring.  Only that CPU writes it.  An interrupt handler that
+   traces while the interrupted code is halfway through a record gets
+   the next slot, because slots are claimed by atomically bumping
+   `head', so no lock and no interrupt disabling is needed. */
+struct trace_ring {
+	struct trace_record *records;
+	uint64_t head;              /* Records ever claimed. */
+};
+
+static struct trace_ring rings[CPU_MAX];
+
+bool trace_option;
+bool trace_enabled;
+
+static const char *event_names[TRACE_EVENT_CNT] = {
+	[TRACE_THREAD_NEW] = "thread_new",
+	[TRACE_SWITCH] = "switch",
+	[TRACE_WAKEUP] = "wakeup",
+	[TRACE_PAGE_FAULT] = "page_fault",
+	[TRACE_SWAP_IN] = "swap_in",
+	[TRACE_SWAP_OUT] = "swap_out",
+	[TRACE_DISK_ISSUE] = "disk_issue",
+	[TRACE_DISK_DONE] = "disk_done",
+	[TRACE_SYSCALL_ENTER] = "syscall_enter",
+	[TRACE_SYSCALL_EXIT] = "syscall_exit",
+};
+
+/* Allocates the rings and starts tracing, if -trace was given.  Must
+   be called after palloc_init(). */
+void
+trace_init (void) {
+	if (!trace_option)
+		return;
+
+	for (int i = 0; i < CPU_MAX; i++) {
+		rings[i].records = palloc_get_multiple (PAL_ZERO, TRACE_PAGES);
+		if (rings[i].records == NULL) {
+			printf ("trace: out of memory, not tracing\n");
+			for (int j = 0; j < i; j++)
+				palloc_free_multiple (rings[j].records, TRACE_PAGES);
+			return;
+		}
+	}
+	__atomic_store_n (&trace_enabled, true, __ATOMIC_RELEASE);
+}
+
+/* Records EVENT with arguments A0 and A1.  Use the trace() macro,
+   which skips the call when tracing is off. */
+void
+trace_emit (enum trace_event event, uint64_t a0, uint64_t a1) {
+	struct trace_ring *ring = &rings[cpu_current ()->id];
+	uint64_t slot = __atomic_fetch_add (&ring->head, 1, __ATOMIC_RELAXED);
+	struct trace_record *r = &ring->records[slot % TRACE_RECORDS];
+
+	r->tsc = timer_tsc ();
+	r->event = event;
+	r->arg[0] = a0;
+	r->arg[1] = a1;
+}
+
+/* Stops tracing and dumps every CPU's ring, oldest record first, as
+   "trace CPU NS EVENT A0 A1" lines, NS being nanoseconds of TSC time
+   and the arguments in hex. */
+void
+trace_print (void) {
+	if (!trace_enabled)
+		return;
+	__atomic_store_n (&trace_enabled, false, __ATOMIC_RELEASE);
+
+	for (int cpu = 0; cpu < CPU_MAX; cpu++) {
+		struct trace_ring *ring = &rings[cpu];
+		uint64_t first = ring->head > TRACE_RECORDS
+			? ring->head - TRACE_RECORDS : 0;
+
+		if (ring->head == 0)
+			continue;
+		printf ("Trace: CPU %d, %llu records (%llu overwritten)\n", cpu,
+				(unsigned long long) (ring->head - first),
+				(unsigned long long) first);
+		for (uint64_t i = first; i < ring->head; i++) {
+			struct trace_record *r = &ring->records[i % TRACE_RECORDS];
+			printf ("trace %d %lld %s %#llx %#llx\n", cpu,
+					(long long) timer_tsc_to_ns (r->tsc),
+					r->event < TRACE_EVENT_CNT ? event_names[r->event] : "?",
+					(unsigned long long) r->arg[0],
+					(unsigned long long) r->arg[1]);
+		}
+	}
+}
@@ -0,0 +1,185 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+
+/* Shared queue for work with no need of its own worker. */
+struct workqueue *system_wq;
+
+static thread_func worker;
+static void delayed_work_fire (void *dw_);
+
+/* Creates system_wq.  Must be called after thread_start(). */
+void
+workqueue_init (void) {
+	system_wq = workqueue_create ("events", PRI_DEFAULT);
+	if (system_wq == NULL)
+		PANIC ("cannot create system workqueue");
+}
+
+/* Creates a workqueue whose worker thread, named NAME, runs at
+   PRIORITY.  Returns the queue, or a null pointer if memory or the
+   thread could not be allocated.  Workqueues are never destroyed. */
+struct workqueue *
+workqueue_create (const char *name, int priority) {
+	struct workqueue *wq = malloc (sizeof *wq);
+
+	if (wq == NULL)
+		return NULL;
+	strlcpy (wq->name, name, sizeof wq->name);
+	list_init (&wq->items);
+	sema_init (&wq->ready, 0);
+	if (thread_create (wq->name, priority, worker, wq) == TID_ERROR) {
+		free (wq);
+		return NULL;
+	}
+	return wq;
+}
+
+/* Initializes W to call FUNC (AUX) when it runs. */
+void
+work_init (struct work *w, work_func *func, void *aux) {
+	ASSERT (w != NULL);
+	ASSERT (func != NULL);
+
+	w->func = func;
+	w->aux = aux;
+	w->pending = false;
+}
+
+/* Queues W on WQ.  Returns false, doing nothing, if W is already
+   pending.  May be called from an interrupt handler.  Once W starts
+   running it is no longer pending and may be queued again, even by its
+   own FUNC. */
+bool
+queue_work (struct workqueue *wq, struct work *w) {
+	enum intr_level old_level = intr_disable ();
+	bool queued = !w->pending;
+
+	if (queued) {
+		w->pending = true;
+		list_push_back (&wq->items, &w->elem);
+		sema_up (&wq->ready);
+	}
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Queues W on system_wq. */
+bool
+schedule_work (struct work *w) {
+	return queue_work (system_wq, w);
+}
+
+/* Takes W off its queue if it has not started yet.  Returns true if it
+   was pending.  Does not wait for a W that is already running. */
+bool
+cancel_work (struct work *w) {
+	enum intr_level old_level = intr_disable ();
+	bool was_pending = w->pending;
+
+	if (was_pending) {
+		list_remove (&w->elem);
+		w->pending = false;
+	}
+	intr_set_level (old_level);
+	return was_pending;
+}
+
+static void
+flush_barrier (void *done) {
+	sema_up (done);
+}
+
+/* Waits until every work queued on WQ before the call has run.  Must
+   not be called from WQ's own worker. */
+void
+flush_workqueue (struct workqueue *wq) {
+	struct semaphore done;
+	struct work barrier;
+
+	ASSERT (!intr_context ());
+
+	sema_init (&done, 0);
+	work_init (&barrier, flush_barrier, &done);
+	queue_work (wq, &barrier);
+	sema_down (&done);
+}
+
+/* Initializes DW to call FUNC (AUX) from a workqueue after a delay. */
+void
+delayed_work_init (struct delayed_work *dw, work_func *func, void *aux) {
+	work_init (&dw->work, func, aux);
+	dw->wq = NULL;
+	timer_event_init (&dw->timer, delayed_work_fire, dw);
+}
+
+/* Queues DW on WQ once TICKS timer ticks have passed, or right away if
+   TICKS <= 0.  Returns false, doing nothing, if DW is already waiting
+   for its timer or pending on a queue.  May be called from an
+   interrupt handler. */
+bool
+queue_delayed_work (struct workqueue *wq, struct delayed_work *dw,
+		int64_t ticks) {
+	enum intr_level old_level = intr_disable ();
+	bool queued = !dw->timer.pending && !dw->work.pending;
+
+	if (queued) {
+		dw->wq = wq;
+		if (ticks <= 0)
+			queue_work (wq, &dw->work);
+		else
+			timer_event_add (&dw->timer, timer_ticks () + ticks);
+	}
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Cancels DW's timer or takes it off its queue, whichever applies.
+   Returns true if DW had not started yet. */
+bool
+cancel_delayed_work (struct delayed_work *dw) {
+	enum intr_level old_level = intr_disable ();
+	bool was_pending = timer_event_cancel (&dw->timer)
+		|| cancel_work (&dw->work);
+
+	intr_set_level (old_level);
+	return was_pending;
+}
+
+/* Timer callback for a delayed work: only queues it. */
+static void
+delayed_work_fire (void *dw_) {
+	struct delayed_work *dw = dw_;
+
+	queue_work (dw->wq, &dw->work);
+}
+
+/* Worker thread body: runs WQ_'s works one at a time, in the order
+   they were queued, with interrupts on. */
+static void
+worker (void *wq_) {
+	struct workqueue *wq = wq_;
+
+	for (;;) {
+		enum intr_level old_level;
+		struct work *w = NULL;
+
+		sema_down (&wq->ready);
+
+		/* A work cancelled after it was queued leaves an extra up
+		   behind, so the list may be empty. */
+		old_level = intr_disable ();
+		if (!list_empty (&wq->items)) {
+			w = list_entry (list_pop_front (&wq->items), struct work, elem);
+			w->pending = false;
+		}
+		intr_set_level (old_level);
+
+		if (w != NULL)
+			w->func (w->aux);
+	}
+}
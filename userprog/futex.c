@@ -0,0 +1,206 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/vm.h"
+#endif
+
+/* Fast user-space mutexes.
+ *
+ * User programs keep their lock state in ordinary memory and only
+ * enter the kernel to sleep when the lock is contended (futex_wait)
+ * or to wake a sleeper (futex_wake).  Sleepers are queued by the
+ * futex word they wait on, identified by address space and user
+ * virtual address, so threads sharing an address space meet in the
+ * same queue while separate processes never do.
+ *
+ * 대기 큐는 처음 기다리는 스레드가 만들고, 마지막 스레드를 깨울 때
+ * 지운다. */
+
+/* Waiters on one futex word. */
+struct futex_queue {
+	uint64_t *pml4;             /* Address space. */
+	const int *uaddr;           /* User virtual address of the word. */
+	struct list waiters;        /* futex_waiters, oldest first. */
+	struct hash_elem elem;      /* Element in futex_table. */
+};
+
+/* One sleeping thread, on its own kernel stack. */
+struct futex_waiter {
+	struct semaphore sema;      /* Upped by futex_wake(). */
+	struct list_elem elem;      /* Element in futex_queue's waiters. */
+};
+
+/* All futex words with at least one waiter. */
+static struct hash futex_table;
+
+/* Protects futex_table and every queue in it. */
+static struct lock futex_lock;
+
+static uint64_t
+futex_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct futex_queue *q = hash_entry (e, struct futex_queue, elem);
+	uintptr_t key[2] = { (uintptr_t) q->pml4, (uintptr_t) q->uaddr };
+
+	return hash_bytes (key, sizeof key);
+}
+
+static bool
+futex_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct futex_queue *a = hash_entry (a_, struct futex_queue, elem);
+	const struct futex_queue *b = hash_entry (b_, struct futex_queue, elem);
+
+	if (a->pml4 != b->pml4)
+		return a->pml4 < b->pml4;
+	return a->uaddr < b->uaddr;
+}
+
+void
+futex_init (void) {
+	hash_init (&futex_table, futex_hash, futex_less, NULL);
+	lock_init (&futex_lock);
+}
+
+/* Returns the queue for UADDR in the current address space, or NULL
+   if nobody waits there.  futex_lock must be held. */
+static struct futex_queue *
+futex_lookup (const int *uaddr) {
+	struct futex_queue key;
+	struct hash_elem *e;
+
+	key.pml4 = thread_current ()->pml4;
+	key.uaddr = uaddr;
+	e = hash_find (&futex_table, &key.elem);
+	return e != NULL ? hash_entry (e, struct futex_queue, elem) : NULL;
+}
+
+/* Makes sure the futex word at UADDR is a mapped, aligned user
+   address and will stay resident while it is read. */
+static bool
+futex_grab (const int *uaddr) {
+	if (uaddr == NULL || (uintptr_t) uaddr % sizeof *uaddr != 0
+			|| !is_user_vaddr (uaddr))
+		return false;
+#ifdef VM
+	return vm_pin_user_range (uaddr, sizeof *uaddr, false);
+#else
+	return pml4_get_page (thread_current ()->pml4, uaddr) != NULL;
+#endif
+}
+
+static void
+futex_put (const int *uaddr UNUSED) {
+#ifdef VM
+	vm_unpin_user_range (uaddr, sizeof *uaddr);
+#endif
+}
+
+/* If *UADDR still equals VAL, sleeps until futex_wake() on UADDR and
+   returns 0.  Otherwise, or if UADDR is invalid, returns -1 at once.
+   The comparison and the enqueue happen under futex_lock, so a wake
+   issued after the caller changed *UADDR cannot be missed. */
+int
+futex_wait (int *uaddr, int val) {
+	struct futex_queue *q;
+	struct futex_waiter w;
+
+	if (!futex_grab (uaddr))
+		return -1;
+
+	lock_acquire (&futex_lock);
+	/* process_exit_threads () is waking everyone up: don't sleep. */
+	if (*uaddr != val || thread_current ()->leader->group_exiting) {
+		lock_release (&futex_lock);
+		futex_put (uaddr);
+		return -1;
+	}
+
+	q = futex_lookup (uaddr);
+	if (q == NULL) {
+		q = malloc (sizeof *q);
+		if (q == NULL) {
+			lock_release (&futex_lock);
+			futex_put (uaddr);
+			return -1;
+		}
+		q->pml4 = thread_current ()->pml4;
+		q->uaddr = uaddr;
+		list_init (&q->waiters);
+		hash_insert (&futex_table, &q->elem);
+	}
+	sema_init (&w.sema, 0);
+	list_push_back (&q->waiters, &w.elem);
+	lock_release (&futex_lock);
+	futex_put (uaddr);
+
+	sema_down (&w.sema);
+	return 0;
+}
+
+/* Wakes up to CNT threads sleeping on UADDR, oldest first, and returns
+   how many were woken. */
+int
+futex_wake (int *uaddr, int cnt) {
+	struct futex_queue *q;
+	int woken = 0;
+
+	if (uaddr == NULL || !is_user_vaddr (uaddr))
+		return -1;
+
+	lock_acquire (&futex_lock);
+	q = futex_lookup (uaddr);
+	if (q != NULL) {
+		while (woken < cnt && !list_empty (&q->waiters)) {
+			struct futex_waiter *w = list_entry (list_pop_front (&q->waiters),
+					struct futex_waiter, elem);
+			sema_up (&w->sema);
+			woken++;
+		}
+		if (list_empty (&q->waiters)) {
+			hash_delete (&futex_table, &q->elem);
+			free (q);
+		}
+	}
+	lock_release (&futex_lock);
+	return woken;
+}
+
+/* Wakes every thread sleeping on any futex word in address space
+   PML4, so that they notice their process is exiting. */
+void
+futex_wake_all (uint64_t *pml4) {
+	struct hash_iterator i;
+	struct futex_queue *q;
+
+	lock_acquire (&futex_lock);
+	do {
+		/* Deleting invalidates the iterator, so start over after
+		   each queue. */
+		q = NULL;
+		hash_first (&i, &futex_table);
+		while (hash_next (&i)) {
+			struct futex_queue *tmp = hash_entry (hash_cur (&i),
+					struct futex_queue, elem);
+			if (tmp->pml4 == pml4) {
+				q = tmp;
+				break;
+			}
+		}
+		if (q != NULL) {
+			while (!list_empty (&q->waiters))
+				sema_up (&list_entry (list_pop_front (&q->waiters),
+							struct futex_waiter, elem)->sema);
+			hash_delete (&futex_table, &q->elem);
+			free (q);
+		}
+	} while (q != NULL);
+	lock_release (&futex_lock);
+}
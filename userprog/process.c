@@ -21,6 +21,8 @@
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
+#include "threads/malloc.h"
+#include "userprog/futex.h"
 #include "intrinsic.h"
 #include "lib/stdio.h"
 #ifdef VM
@@ -31,6 +33,19 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static void start_uthread (void *);
+static void uthread_release (int status);
+static bool child_forked (void *ch_st_);
+static bool child_exited (void *ch_st_);
+static bool uthread_exited (void *st_);
+
+/* User threads.  Thread stacks sit below the main stack's 1 MB growth
+ * area, one slot per thread, each with an unmapped guard page under it. */
+#define UTHREAD_MAX 16                  /* Non-leader threads per process. */
+#define UTHREAD_STACK_PAGES 16          /* Stack size, in pages. */
+#define UTHREAD_STACK_TOP(SLOT) \
+	((uint8_t *) USER_STACK - (1 << 20) \
+	 - (SLOT) * (UTHREAD_STACK_PAGES + 1) * PGSIZE)
 
 //struct lock file_lock;	
 
@@ -151,8 +166,7 @@ process_fork (const char *name, struct intr_frame *if_) {
 	list_push_back(&thread_current()->child_list, &ch_st->elem);
 	ch_st->tid = tid;
 	ch_st->wait_called = false;
-	sema_init(&ch_st->sema_fork, 0);
-	sema_init(&ch_st->sema_wait, 0);
+	wait_queue_init(&ch_st->wq);
 	//printf("list begin: %p\n", list_begin(&thread_current()->child_list));
 
 	//printf("inserted tid: %d\n", ch_st->tid);
@@ -161,7 +175,7 @@ process_fork (const char *name, struct intr_frame *if_) {
 	intr_set_level(old_level);
 
 	//printf("right before return tid in fork\n");
-	sema_down(&ch_st->sema_fork);
+	wait_event(&ch_st->wq, child_forked, ch_st);
 
 
 	// 비정상종료했지만, 이 조건이 없으면 정상 종료했다고 판단해버림. 그래서
@@ -252,6 +266,7 @@ __do_fork (void *aux) {
 	// 부모 쓰레드가 전환 전에 저장했던 레지스터 정보를 받아옴
 	//struct intr_frame *parent_if = &parent->tf;
 	bool succ = true;
+	enum intr_level old_level;
 
 	/* 1. Read the cpu context to local stack. */
 	// 자식 프로세스에 부모 프로세스 레지스터 정보를 복사함
@@ -292,7 +307,11 @@ __do_fork (void *aux) {
 	process_activate (current);
 #ifdef VM
 	supplemental_page_table_init (&current->spt);
-	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
+	/* 부모 프로세스의 다른 스레드가 spt를 바꾸지 못하게 한다. */
+	lock_acquire (&parent->leader->spt.lock);
+	succ = supplemental_page_table_copy (&current->spt, &parent->leader->spt);
+	lock_release (&parent->leader->spt.lock);
+	if (!succ)
 		goto error;
 #else
 	
@@ -341,8 +360,12 @@ __do_fork (void *aux) {
 	// //printf("do fork tid: %d\n", ch_st->tid);
 	// if(!ch_st) goto error;
 	// current->child_status = ch_st;
+	/* 깨우기 전에 부모가 ch_st를 해제하지 못하게 인터럽트를 끈다. */
+	old_level = intr_disable ();
 	ch_st->fork_success = true;
-	sema_up(&ch_st->sema_fork);
+	ch_st->fork_done = true;
+	wake_up(&ch_st->wq);
+	intr_set_level (old_level);
 	//printf("_do_fork\n");
 	
 	process_init ();
@@ -365,7 +388,10 @@ error:
 	if(current->user_prog != NULL) {
 		file_close(current->user_prog);
 	}
-	sema_up(&ch_st->sema_fork);
+	old_level = intr_disable ();
+	ch_st->fork_done = true;
+	wake_up(&ch_st->wq);
+	intr_set_level (old_level);
 
 	//if (current->pml4) pml4_destroy(current->pml4);
 	
@@ -481,19 +507,16 @@ process_wait (tid_t child_tid UNUSED) {
 	// list_init(&ch_st->sema_wait);
 	// exit할 때 가지 기다림
 	//printf("process_wait: %d\n", child_tid);
-	sema_down(&ch_st->sema_wait);
+	wait_event(&ch_st->wq, child_exited, ch_st);
+	/* 프로세스가 exit 중이라 깨어났으면 나중에 다시 기다릴 수 있게 둔다. */
+	if(!ch_st->has_exited) {
+		ch_st->wait_called = false;
+		return -1;
+	}
 	// printf("after sema down child id: %d\n", child_tid);
 	// exit 후
 	//printf("process wait done: %d\n", child_tid);
 
-	 
-
-	if(!ch_st->has_exited){
-		list_remove(&ch_st->elem);
-		free(ch_st);
-		return TID_ERROR;
-	}
-
 	//lock_acquire(&thread_current()->childlist_lock);
 	int exit_status = ch_st->exit_status;
 	// 반환
@@ -507,6 +530,20 @@ process_wait (tid_t child_tid UNUSED) {
 	// return -1;
 }
 
+/* wait_event () predicates on a child_status. */
+static bool
+child_forked (void *ch_st_) {
+	return ((struct child_status *) ch_st_)->fork_done;
+}
+
+/* Also stops when the waiting process is exiting, so that
+   process_group_exit () can pull the waiter out. */
+static bool
+child_exited (void *ch_st_) {
+	return ((struct child_status *) ch_st_)->has_exited
+		|| thread_current ()->leader->group_exiting;
+}
+
 /* Exit the process. This function is called by thread_exit (). */
 // 현재 실행 중인 프로세스를 정상적으로 종료합니다.
 void
@@ -529,6 +566,14 @@ process_exit (void) {
 
 	// printf("%s: exit(%d)\n", curr->name, status);
 	//printf("process_exit");
+
+	/* 유저 스레드는 leader의 자원을 빌려 쓰고 있으므로 정리하지 않는다. */
+	if (curr->leader != curr) {
+		if (curr->uthread_status != NULL)
+			uthread_release (-1);
+		return;
+	}
+	process_exit_threads (-1);
 	process_cleanup ();
 }
 
@@ -574,6 +619,291 @@ process_activate (struct thread *next) {
 	tss_update (next);
 }
 
+/* Arguments for start_uthread (). */
+struct uthread_args {
+	struct thread *leader;          /* Process to join. */
+	struct uthread_status *status;  /* New thread's status record. */
+	int slot;                       /* Stack slot. */
+	struct intr_frame if_;          /* Initial user-mode registers. */
+};
+
+/* Removes the first PAGE_CNT pages of the stack in SLOT from LEADER's
+ * address space. */
+static void
+uthread_free_stack (struct thread *leader, int slot, int page_cnt) {
+	uint8_t *top = UTHREAD_STACK_TOP (slot);
+
+	lock_acquire (&leader->spt.lock);
+	for (int i = 0; i < page_cnt; i++) {
+		struct page *page = spt_find_page (&leader->spt, top - (i + 1) * PGSIZE);
+		if (page != NULL)
+			spt_remove_page (&leader->spt, page);
+	}
+	lock_release (&leader->spt.lock);
+}
+
+/* Starts a thread in the current process that runs ENTRY (FUNC, AUX)
+ * in user mode, on a stack of its own, sharing the process's address
+ * space, open files and mappings.  Returns the new thread's tid, or
+ * TID_ERROR if it cannot be created. */
+tid_t
+process_thread_create (void *entry, void *func, void *aux) {
+	struct thread *leader = thread_current ()->leader;
+	struct uthread_args *args;
+	struct uthread_status *st;
+	enum intr_level old_level;
+	uint8_t *top;
+	int slot, i;
+	tid_t tid;
+
+	if (!is_user_vaddr (entry))
+		return TID_ERROR;
+
+	/* leader의 uthread_slots, uthread_cnt, uthread_list는
+	   uthread_release ()처럼 인터럽트를 꺼서 보호한다. */
+	old_level = intr_disable ();
+	slot = UTHREAD_MAX;
+	if (!leader->group_exiting)
+		for (slot = 0; slot < UTHREAD_MAX; slot++)
+			if (!(leader->uthread_slots & (1u << slot)))
+				break;
+	if (slot < UTHREAD_MAX)
+		leader->uthread_slots |= 1u << slot;
+	intr_set_level (old_level);
+	if (slot == UTHREAD_MAX)
+		return TID_ERROR;
+
+	args = calloc (1, sizeof *args);
+	st = calloc (1, sizeof *st);
+	if (args == NULL || st == NULL)
+		goto error;
+
+	/* 스택은 lazy하게 할당하고, 처음 닿을 때 fault로 올린다. */
+	top = UTHREAD_STACK_TOP (slot);
+	lock_acquire (&leader->spt.lock);
+	for (i = 0; i < UTHREAD_STACK_PAGES; i++)
+		if (!vm_alloc_page (VM_ANON | VM_MARKER_0, top - (i + 1) * PGSIZE, true))
+			break;
+	lock_release (&leader->spt.lock);
+	if (i < UTHREAD_STACK_PAGES) {
+		uthread_free_stack (leader, slot, i);
+		goto error;
+	}
+
+	args->leader = leader;
+	args->status = st;
+	args->slot = slot;
+	args->if_.ds = args->if_.es = args->if_.ss = SEL_UDSEG;
+	args->if_.cs = SEL_UCSEG;
+	args->if_.eflags = FLAG_IF | FLAG_MBS;
+	args->if_.rip = (uintptr_t) entry;
+	args->if_.R.rdi = (uint64_t) func;
+	args->if_.R.rsi = (uint64_t) aux;
+	/* As if ENTRY had been called: rsp + 8 is 16-byte aligned. */
+	args->if_.rsp = (uintptr_t) top - 8;
+
+	wait_queue_init (&st->wq);
+
+	/* process_exit_threads ()가 uthread_cnt를 보기 시작했으면 늦었다. */
+	old_level = intr_disable ();
+	if (leader->group_exiting) {
+		intr_set_level (old_level);
+		uthread_free_stack (leader, slot, UTHREAD_STACK_PAGES);
+		goto error;
+	}
+	leader->uthread_cnt++;
+	list_push_back (&leader->uthread_list, &st->elem);
+	intr_set_level (old_level);
+
+	tid = thread_create (leader->name, PRI_DEFAULT, start_uthread, args);
+	if (tid == TID_ERROR) {
+		uthread_free_stack (leader, slot, UTHREAD_STACK_PAGES);
+		old_level = intr_disable ();
+		list_remove (&st->elem);
+		leader->uthread_cnt--;
+		sema_up (&leader->uthread_sema);
+		intr_set_level (old_level);
+		goto error;
+	}
+	st->tid = tid;
+	return tid;
+
+error:
+	old_level = intr_disable ();
+	leader->uthread_slots &= ~(1u << slot);
+	intr_set_level (old_level);
+	free (args);
+	free (st);
+	return TID_ERROR;
+}
+
+/* A thread function that enters a thread made by process_thread_create (). */
+static void
+start_uthread (void *aux) {
+	struct uthread_args *args = aux;
+	struct thread *curr = thread_current ();
+	struct thread *leader = args->leader;
+	struct intr_frame if_;
+	enum intr_level old_level;
+
+	memcpy (&if_, &args->if_, sizeof if_);
+
+	/* thread_create ()가 만든 테이블 대신 leader의 것을 쓴다. */
+	free (curr->fd_table);
+	free (curr->mmap_table);
+	old_level = intr_disable ();
+	curr->leader = leader;
+	curr->uthread_status = args->status;
+	curr->uthread_status->thread = curr;
+	curr->uthread_slot = args->slot;
+	curr->pml4 = leader->pml4;
+	curr->fd_table = leader->fd_table;
+	curr->mmap_table = leader->mmap_table;
+	intr_set_level (old_level);
+	free (args);
+
+	process_activate (curr);
+	do_iret (&if_);
+	NOT_REACHED ();
+}
+
+/* wait_event () predicate on a uthread_status.  Like child_exited (),
+ * also stops when the process is exiting. */
+static bool
+uthread_exited (void *st_) {
+	return ((struct uthread_status *) st_)->has_exited
+		|| thread_current ()->leader->group_exiting;
+}
+
+/* Waits for thread TID of the current process to exit and returns the
+ * status it exited with.  Returns -1 at once if TID is not a thread of
+ * this process, is the caller, or has already been joined, and returns
+ * -1 if the process starts exiting during the wait. */
+int
+process_thread_join (tid_t tid) {
+	struct thread *leader = thread_current ()->leader;
+	struct uthread_status *st = NULL;
+	enum intr_level old_level;
+	int status;
+
+	old_level = intr_disable ();
+	for (struct list_elem *e = list_begin (&leader->uthread_list);
+			e != list_end (&leader->uthread_list); e = list_next (e)) {
+		struct uthread_status *tmp = list_entry (e, struct uthread_status, elem);
+		if (tmp->tid == tid) {
+			st = tmp;
+			break;
+		}
+	}
+	if (st == NULL || st->join_called || tid == thread_tid ()) {
+		intr_set_level (old_level);
+		return -1;
+	}
+	st->join_called = true;
+	intr_set_level (old_level);
+
+	wait_event (&st->wq, uthread_exited, st);
+	/* exit 중이면 st는 process_exit_threads ()가 치운다. */
+	if (!st->has_exited)
+		return -1;
+
+	status = st->exit_status;
+	old_level = intr_disable ();
+	list_remove (&st->elem);
+	intr_set_level (old_level);
+	free (st);
+	return status;
+}
+
+/* Gives the current non-leader thread's stack and its share of the
+ * process back to the leader, and reports STATUS to a joiner. */
+static void
+uthread_release (int status) {
+	struct thread *curr = thread_current ();
+	struct thread *leader = curr->leader;
+	struct uthread_status *st = curr->uthread_status;
+	enum intr_level old_level;
+
+	uthread_free_stack (leader, curr->uthread_slot, UTHREAD_STACK_PAGES);
+
+	/* leader가 주소 공간을 지우기 전에 빠져나온다.  uthread_cnt를
+	   줄인 뒤로는 leader가 먼저 끝날 수 있으니 아무것도 건드리지 않는다. */
+	old_level = intr_disable ();
+	st->thread = NULL;
+	curr->uthread_status = NULL;
+	curr->pml4 = NULL;
+	pml4_activate (NULL);
+	curr->fd_table = NULL;
+	curr->mmap_table = NULL;
+	leader->uthread_slots &= ~(1u << curr->uthread_slot);
+	st->exit_status = status;
+	st->has_exited = true;
+	wake_up_all (&st->wq);
+	leader->uthread_cnt--;
+	sema_up (&leader->uthread_sema);
+	intr_set_level (old_level);
+}
+
+/* Terminates the current thread, which must not be its process's
+ * leader, with exit status STATUS.  The process lives on. */
+void
+process_thread_exit (int status) {
+	ASSERT (thread_current ()->leader != thread_current ());
+
+	uthread_release (status);
+	thread_exit ();
+}
+
+/* Marks the current process as exiting with STATUS, unless it already
+ * is, and wakes its other threads so that they notice.  A thread
+ * notices the next time it enters or leaves the kernel or is
+ * interrupted in user mode.  Those asleep on a futex, in a join, in
+ * process_wait () or on a stdin read are woken up to do so; a thread
+ * blocked anywhere else in the kernel (on a lock, on disk I/O) exits
+ * once that wait ends by itself. */
+void
+process_group_exit (int status) {
+	struct thread *curr = thread_current ();
+	struct thread *leader = curr->leader;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	if (!leader->group_exiting) {
+		leader->group_exiting = true;
+		leader->group_exit_status = status;
+	}
+	if (leader != curr)
+		wait_event_kick (leader);
+	for (struct list_elem *e = list_begin (&leader->uthread_list);
+			e != list_end (&leader->uthread_list); e = list_next (e)) {
+		struct uthread_status *st = list_entry (e, struct uthread_status, elem);
+		if (st->thread != NULL && st->thread != curr)
+			wait_event_kick (st->thread);
+	}
+	intr_set_level (old_level);
+
+	if (leader->pml4 != NULL)
+		futex_wake_all (leader->pml4);
+}
+
+/* Called by the leader when its process exits with STATUS: makes the
+ * other threads exit, with process_group_exit (), and waits until they
+ * have. */
+void
+process_exit_threads (int status) {
+	struct thread *curr = thread_current ();
+
+	ASSERT (curr->leader == curr);
+
+	process_group_exit (status);
+	while (curr->uthread_cnt > 0)
+		sema_down (&curr->uthread_sema);
+
+	while (!list_empty (&curr->uthread_list))
+		free (list_entry (list_pop_front (&curr->uthread_list),
+					struct uthread_status, elem));
+}
+
 /* We load ELF binaries.  The following definitions are taken
  * from the ELF specification, [ELF1], more-or-less verbatim.  */
 
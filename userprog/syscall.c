@@ -15,6 +15,9 @@
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "include/vm/vm.h"
+#include "userprog/futex.h"
+#include "threads/trace.h"
+#include "devices/input.h"
 // #include "filesys/inode.h"
 // #include "threads/malloc.h"
 // /* An open file. */
@@ -42,11 +45,21 @@ unsigned tell(int fd);
 void close (int fd);
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int fault_stat (int kind, struct fault_stat *st);
+int mincore (void *addr, size_t length, unsigned char *vec);
+int frame_limit (int pages);
+int lockstat (struct lockstat *buf, int max);
+int futex (int *uaddr, int op, int val);
+void uthread_exit (int status);
 bool isValidAddress(const void *ptr);
 bool isValidString(const char *str);
+static bool group_exiting(void *leader_);
 
 struct lock syscall_lock;
 
+/* Largest piece of a user buffer that read() pins at once. */
+#define READ_PIN_CHUNK (16 * PGSIZE)
+
 /* System call.
  *
  * Previously system call services was handled by the interrupt handler
@@ -73,6 +86,7 @@ syscall_init (void) {
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
 
 	lock_init(&syscall_lock);
+	futex_init();
 }
 
 /* The main system call interface */
@@ -81,9 +95,11 @@ syscall_handler (struct intr_frame *f UNUSED) {
 	// TODO: Your implementation goes here.
 
 	thread_current()->rsp = f->rsp;
+	syscall_exit_if_killed();
 
 	// 시스템 콜 번호
 	uint64_t syscall_num = f->R.rax;
+	trace (TRACE_SYSCALL_ENTER, syscall_num, thread_current()->tid);
 
 	switch(syscall_num){
 		case SYS_HALT:
@@ -135,11 +151,55 @@ syscall_handler (struct intr_frame *f UNUSED) {
 		case SYS_MUNMAP:
 			munmap((void *)f->R.rdi);
 			break;
+		case SYS_FAULT_STAT:
+			f->R.rax = fault_stat((int)f->R.rdi, (struct fault_stat *)f->R.rsi);
+			break;
+		case SYS_MINCORE:
+			f->R.rax = mincore((void *)f->R.rdi, (size_t)f->R.rsi, (unsigned char *)f->R.rdx);
+			break;
+		case SYS_FRAME_LIMIT:
+			f->R.rax = frame_limit((int)f->R.rdi);
+			break;
+		case SYS_LOCKSTAT:
+			f->R.rax = lockstat((struct lockstat *)f->R.rdi, (int)f->R.rsi);
+			break;
+		case SYS_FUTEX:
+			f->R.rax = futex((int *)f->R.rdi, (int)f->R.rsi, (int)f->R.rdx);
+			break;
+		case SYS_UTHREAD_CREATE:
+			f->R.rax = process_thread_create((void *)f->R.rdi, (void *)f->R.rsi, (void *)f->R.rdx);
+			break;
+		case SYS_UTHREAD_JOIN:
+			f->R.rax = process_thread_join((tid_t)f->R.rdi);
+			break;
+		case SYS_UTHREAD_EXIT:
+			uthread_exit((int)f->R.rdi);
+			break;
 		default:
 			thread_exit();
 	}
 	
+	trace (TRACE_SYSCALL_EXIT, syscall_num, f->R.rax);
+	syscall_exit_if_killed();
+}
+
+/* Exits the current thread if another thread of its process has
+   called exit().  Checked on the way into and out of the kernel, and
+   by intr_handler() when it interrupts user code. */
+void
+syscall_exit_if_killed (void) {
+	struct thread *curr = thread_current();
 
+	if(curr->pml4 == NULL || !curr->leader->group_exiting) return;
+	intr_enable();
+	if(curr->leader == curr) exit(curr->group_exit_status);
+	process_thread_exit(-1);
+}
+
+/* wait_event() predicate: is process LEADER_ exiting? */
+static bool
+group_exiting(void *leader_) {
+	return ((struct thread *) leader_)->group_exiting;
 }
 
 void halt(void){
@@ -148,6 +208,18 @@ void halt(void){
 
 void exit(int status){
 	struct thread* curr = thread_current();
+
+	if(lock_held_by_current_thread(&syscall_lock)) lock_release(&syscall_lock);
+
+	/* 어느 스레드가 exit()을 불러도 프로세스 전체가 끝난다.  leader가
+	   나머지 스레드를 정리하고 종료 메시지를 찍는다. */
+	if(curr->leader != curr) {
+		process_group_exit(status);
+		process_thread_exit(status);
+	}
+	process_exit_threads(status);
+	status = curr->group_exit_status;
+
 	//부모프로세스에서 자식프로세스의 종료 정보를 저장
 	if(curr->user_prog != NULL) {
 		file_allow_write(curr->user_prog);
@@ -181,17 +253,16 @@ void exit(int status){
 	if(ch_st != NULL){
 
 		//printf("exit tid: %d\n", ch_st->tid);
-		ch_st->exit_status = status;
-		ch_st->has_exited = true;
 		printf("%s: exit(%d)\n", curr->name, status);
-		sema_up(&ch_st->sema_wait);
 
-		if(!list_empty(&ch_st->sema_fork.waiters)){
-			sema_up(&ch_st->sema_fork);
-		}
-		if(!list_empty(&ch_st->sema_wait.waiters)){
-			sema_up(&ch_st->sema_wait);
-		}
+		/* 부모가 깨어나면 ch_st를 해제하므로, 표시와 깨우기를
+		   한 번에 한다. */
+		enum intr_level old_level = intr_disable();
+		ch_st->exit_status = status;
+		ch_st->has_exited = true;
+		ch_st->fork_done = true;
+		wake_up(&ch_st->wq);
+		intr_set_level(old_level);
 	}
 	else{
 		
@@ -214,6 +285,9 @@ pid_t fork (const char *thread_name){
 int exec(const char *file_name){
 	//printf("exec file name: %s, addr: %p\n", file_name, file_name);
 	if(!isValidString(file_name)) exit(-1);
+	/* 다른 스레드가 아직 이 주소 공간을 쓰고 있다. */
+	if(thread_current()->leader != thread_current() || thread_current()->uthread_cnt > 0)
+		return -1;
 	char *fn_copy = palloc_get_page(PAL_ZERO);
 	if(fn_copy == NULL) return -1;
 	strlcpy(fn_copy, file_name, PGSIZE);
@@ -324,6 +398,11 @@ int read(int fd, void *buffer, unsigned size){
 		char c;
 		int i=0;
 		for(; i<size; i++){
+			/* 키를 기다리는 동안에도 프로세스 exit에 깨어날 수 있게 한다. */
+			if(!input_wait(group_exiting, thread_current()->leader)) {
+				lock_release(&syscall_lock);
+				return i;
+			}
 			c = input_getc();
 			((char *)buffer)[i] = c;
 			if(c == '\n') break;
@@ -333,22 +412,36 @@ int read(int fd, void *buffer, unsigned size){
 	}
 	else if(fd >= 3){
 		struct thread* curr = thread_current();
-		struct file* f = curr->fd_table->fd_entries[fd];
+		/* 같은 프로세스의 다른 스레드가 close()해도 f가 해제되지 않도록
+		   lock을 놓기 전에 참조를 잡는다. */
+		struct file* f = file_get(curr->fd_table->fd_entries[fd]);
+		lock_release(&syscall_lock);
 		//printf("f addr: %p\n", f);
 		if(f == NULL) return -1;
-		//printf("inode pointer: %p\n", f->inode);
-		struct page *page = spt_find_page(&curr->spt, buffer);
-		if(page && !page->writable){
-			//printf("2 physical addr: %p\n", page->frame->kva);
-			lock_release(&syscall_lock);
-			exit(-1);
+
+		/* 버퍼를 청크 단위로 pin한 뒤 읽는다. inode lock을 잡은 동안에는
+		   page fault도 eviction도 일어나지 않는다. */
+		int result = 0;
+		while(size > 0){
+			unsigned chunk = READ_PIN_CHUNK - pg_ofs(buffer);
+			if(chunk > size) chunk = size;
+			if(!vm_pin_user_range(buffer, chunk, true)) {
+				file_close(f);
+				exit(-1);
+			}
+
+			lock_acquire(&f->inode->inode_lock);
+			int n = file_read(f, buffer, chunk);
+			lock_release(&f->inode->inode_lock);
+			vm_unpin_user_range(buffer, chunk);
+			//printf("file_read returned %d\n", n);
+
+			result += n;
+			buffer += n;
+			size -= n;
+			if((unsigned) n < chunk) break;
 		}
-		//file_seek(f, 0);
-		lock_acquire(&f->inode->inode_lock);
-		int result = file_read(f, buffer, size);
-		lock_release(&f->inode->inode_lock);
-		//printf("file_read returned %d\n", result);
-		lock_release(&syscall_lock);
+		file_close(f);
 		return result;
 	}
 	lock_release(&syscall_lock);
@@ -385,13 +478,17 @@ int write(int fd, const void *buffer, unsigned size){
 }
 
 void seek(int fd, unsigned position){
+	lock_acquire(&syscall_lock);
 	struct file *file = thread_current()->fd_table->fd_entries[fd];
 	file_seek(file, (off_t)position);
+	lock_release(&syscall_lock);
 }
 
 unsigned tell(int fd){
+	lock_acquire(&syscall_lock);
 	struct file* file = thread_current()->fd_table->fd_entries[fd];
 	off_t offset = file_tell(file);
+	lock_release(&syscall_lock);
 	return offset;
 }
 
@@ -451,7 +548,9 @@ mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	if(addr != pg_round_down(addr)) return NULL;
 	if(length < offset) return NULL;
 	if(filesize(fd) == 0) return NULL;
+	struct supplemental_page_table *spt = &thread_current()->leader->spt;
 	lock_acquire(&syscall_lock);
+	lock_acquire(&spt->lock);
 	//printf("here\n");
 	void *t_addr;
 	t_addr = addr;
@@ -462,9 +561,9 @@ mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	// range of pages does not overlap any existing mapped page
 	while(t_addr < addr + length){
 		//printf("검사\n");
-		if(t_addr > KERN_BASE) return NULL;
-		struct page* page = spt_find_page(&thread_current()->spt, t_addr);
-		if(page) {
+		bool kernel = (uint64_t) t_addr > KERN_BASE;
+		if(kernel || spt_find_page(spt, t_addr) != NULL) {
+			lock_release(&spt->lock);
 			lock_release(&syscall_lock);
 			return NULL;
 		}
@@ -502,6 +601,7 @@ mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 
 		if (!vm_alloc_page_with_initializer (VM_FILE, adrs,
 					writable, lazy_load_segment_mmap, aux)){
+						lock_release(&spt->lock);
 						lock_release(&syscall_lock);
 						return NULL;
 					}
@@ -525,6 +625,7 @@ mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 
 
 	
+	lock_release(&spt->lock);
 	lock_release(&syscall_lock);
 	return addr;
 }	
@@ -588,28 +689,160 @@ munmap (void *addr) {
     struct page *page;
 
     lock_acquire(&syscall_lock);
-    while ((page = spt_find_page(&curr->spt, addr))) {
+    lock_acquire(&curr->leader->spt.lock);
+    while ((page = spt_find_page(&curr->leader->spt, addr))) {
 		struct file_page *file_page UNUSED = &page->file;
 
+		/* 내보내는 중이면 write-back이 끝날 때까지 기다린다. */
+		vm_wait_eviction(page);
 		if(pml4_is_dirty(thread_current()->pml4, page->va)){
 			file_write_at(file_page->file, file_page->upage, file_page->read_bytes, file_page->ofs);
 			pml4_set_dirty(thread_current()->pml4, page->va, false);
 		}
 
-		if(page->frame){
-			list_remove(&page->frame->elem);
-			page->frame->page = NULL;
-			palloc_free_page(page->frame->kva);
-			free(page->frame);
-			page->frame = NULL;
-			
-		}
+		/* clock hand와 resident 수도 frame table 쪽에서 정리한다. */
+		if(page->frame)
+			vm_frame_free(page->frame, true);
 
 		pml4_clear_page(thread_current()->pml4, page->va);
-		spt_remove_page(&thread_current()->spt, page);
+		spt_remove_page(&curr->leader->spt, page);
 		
         addr += PGSIZE;
     }
+    lock_release(&curr->leader->spt.lock);
     lock_release(&syscall_lock);
 
-}
\ No newline at end of file
+}
+int
+fault_stat (int kind, struct fault_stat *st) {
+#ifdef VM
+	struct vm_fault_stat vst;
+
+	if (kind < 0 || kind >= VM_FAULT_TYPE_CNT)
+		return -1;
+	if (!is_user_vaddr (st) || !is_user_vaddr ((uint8_t *) (st + 1) - 1))
+		exit(-1);
+
+	vm_get_fault_stat (kind, &vst);
+	st->count = vst.count;
+	st->cycles = vst.cycles;
+	st->max_cycles = vst.max_cycles;
+	for (int i = 0; i < FAULT_HIST_BUCKETS; i++)
+		st->hist[i] = vst.hist[i];
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/* Stores one MINCORE_* byte per page of [ADDR, ADDR + LENGTH) in VEC.
+   Returns -1 if ADDR is not page-aligned or part of the range is not
+   mapped. */
+int
+mincore (void *addr, size_t length, unsigned char *vec) {
+	struct supplemental_page_table *spt = &thread_current()->leader->spt;
+	size_t page_cnt = (length + PGSIZE - 1) / PGSIZE;
+
+	if(pg_ofs(addr) != 0) return -1;
+	if(!is_user_vaddr(addr) || !is_user_vaddr(addr + length - 1)) return -1;
+	if(length == 0) return 0;
+
+	/* vec에 쓰다가 page fault가 나서 다른 페이지가 evict되지 않게 pin한다.
+	   pin은 fault를 처리하며 spt lock을 잡으므로 lock보다 먼저 한다. */
+	if(!vm_pin_user_range(vec, page_cnt, true)) exit(-1);
+	lock_acquire(&spt->lock);
+	for(size_t i = 0; i < page_cnt; i++){
+		struct page *page = spt_find_page(spt, addr + i * PGSIZE);
+		if(page == NULL) {
+			lock_release(&spt->lock);
+			vm_unpin_user_range(vec, page_cnt);
+			return -1;
+		}
+		if(page->frame != NULL)
+			vec[i] = MINCORE_RESIDENT;
+		else if(VM_TYPE(page->operations->type) == VM_UNINIT)
+			vec[i] = MINCORE_UNTOUCHED;
+		else
+			vec[i] = MINCORE_PAGED_OUT;
+	}
+	lock_release(&spt->lock);
+	vm_unpin_user_range(vec, page_cnt);
+	return 0;
+}
+
+/* Sets this process's soft resident-frame limit to PAGES, 0 for none,
+   and returns the previous limit.  A negative PAGES only queries it.
+   Eviction takes frames from processes above their limit first. */
+int
+frame_limit (int pages) {
+	struct supplemental_page_table *spt = &thread_current()->leader->spt;
+	int old = spt->frame_limit;
+
+	if(pages >= 0)
+		spt->frame_limit = pages;
+	return old;
+}
+
+/* Stores in BUF the statistics of up to MAX lock sites, most time
+   spent waiting first, and returns how many it stored.  Returns -1 if
+   the kernel was built without LOCKSTAT. */
+int
+lockstat (struct lockstat *buf, int max) {
+#ifdef LOCKSTAT
+	struct lock_stat *top[16];
+	size_t cnt;
+
+	if (max < 0)
+		return -1;
+	if (max > 16)
+		max = 16;
+	if (max == 0)
+		return 0;
+	if (!is_user_vaddr (buf) || !is_user_vaddr ((uint8_t *) (buf + max) - 1))
+		exit(-1);
+
+	cnt = lockstat_top (top, max);
+	for (size_t i = 0; i < cnt; i++) {
+		strlcpy (buf[i].name, top[i]->name, sizeof buf[i].name);
+		snprintf (buf[i].site, sizeof buf[i].site, "%s:%d",
+				top[i]->file, top[i]->line);
+		strlcpy (buf[i].max_holder, top[i]->max_holder,
+				sizeof buf[i].max_holder);
+		buf[i].acquired = top[i]->acquired;
+		buf[i].contended = top[i]->contended;
+		buf[i].wait_cycles = top[i]->wait_cycles;
+		buf[i].max_hold_cycles = top[i]->max_hold_cycles;
+	}
+	return cnt;
+#else
+	(void) buf;
+	(void) max;
+	return -1;
+#endif
+}
+
+/* FUTEX_WAIT sleeps while *UADDR == VAL; FUTEX_WAKE wakes up to VAL
+   threads sleeping on UADDR.  See userprog/futex.c. */
+int
+futex (int *uaddr, int op, int val) {
+	switch (op) {
+		case FUTEX_WAIT:
+			return futex_wait(uaddr, val);
+		case FUTEX_WAKE:
+			return futex_wake(uaddr, val);
+		default:
+			return -1;
+	}
+}
+
+/* Terminates the calling thread with STATUS.  The process's initial
+   thread waits for the others first, then exits the whole process. */
+void
+uthread_exit (int status) {
+	struct thread *curr = thread_current();
+
+	if(curr->leader != curr) process_thread_exit(status);
+	while(curr->uthread_cnt > 0 && !curr->group_exiting)
+		sema_down(&curr->uthread_sema);
+	exit(status);
+}
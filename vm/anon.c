@@ -5,6 +5,7 @@
 #include "lib/kernel/bitmap.h"
 #include "include/threads/vaddr.h"
 #include "include/devices/disk.h"
+#include "threads/trace.h"
 //swap slot의 개수: 20160개의 섹터(512byte), 1페이지 크기인 4096byte로 나눔.
 
 /* bitmap */
@@ -58,6 +59,7 @@ anon_swap_in (struct page *page, void *kva) {
 	/* 페이지에 대한 시작 섹터 */
 	disk_sector_t sec_num = anon_page->disk_location;
 	
+	trace (TRACE_SWAP_IN, page->va, sec_num);
 	void *t_kva = page->frame->kva;
 	//printf("swap in target kva: %p\n", t_kva);
 	/* 할당한 프레임(kva)에 디스크에서 불러와서 쓰기. */
@@ -88,10 +90,11 @@ anon_swap_out (struct page *page) {
 	/* 페이지의 시작 섹터 */
 	disk_sector_t sec_num = free_slot * (PGSIZE / DISK_SECTOR_SIZE);
 	
+	trace (TRACE_SWAP_OUT, page->va, sec_num);
 	void *kva = page->frame->kva;
 	/* swap slot에 저장 */
 	for(int i=0; i<(PGSIZE / DISK_SECTOR_SIZE); i++){
-		disk_write(swap_disk, sec_num + i, page->va + DISK_SECTOR_SIZE * i);
+		disk_write(swap_disk, sec_num + i, kva);
 		kva += DISK_SECTOR_SIZE;
 	}
 	
@@ -99,8 +102,9 @@ anon_swap_out (struct page *page) {
 	anon_page->disk_location = sec_num;
 	/* save the location in the swap space. */
 	anon_page->bit_idx = free_slot;
+	page->is_swapped = true;
 	
-	pml4_clear_page(thread_current()->pml4, page->va);
+	pml4_clear_page(page->frame->owner->pml4, page->va);
 	return true;
 }
 
@@ -108,8 +112,13 @@ anon_swap_out (struct page *page) {
 static void
 anon_destroy (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+
+	vm_wait_eviction(page);
+	/* swap slot 반환 */
+	if(page->is_swapped){
+		bitmap_set(b, anon_page->bit_idx, false);
+		page->is_swapped = false;
+	}
 	if(page->frame)
-		palloc_free_page(page->frame->kva);
-	pml4_clear_page(thread_current()->pml4, page->va);
-	free(page->frame);
+		vm_frame_free(page->frame, true);
 }
@@ -52,18 +52,18 @@ file_backed_swap_in (struct page *page, void *kva) {
 static bool
 file_backed_swap_out (struct page *page) {
 	struct file_page *file_page UNUSED = &page->file;
+	uint64_t *pml4 = page->frame->owner->pml4;
 	//printf("file swap out\n");
 
-	if(pml4_is_dirty(thread_current()->pml4, page->va)){
+	if(pml4_is_dirty(pml4, page->va)){
 		file_seek(file_page->file, file_page->ofs);
 		file_write_at(file_page->file, page->frame->kva, file_page->read_bytes, file_page->ofs);
-		pml4_set_dirty(thread_current()->pml4, page->va, false);
+		pml4_set_dirty(pml4, page->va, false);
 	}
 
 
-	page->frame->page = NULL;
-	page->frame = NULL;
-	pml4_clear_page(thread_current()->pml4, page->va);
+	/* page와 frame의 연결은 vm_evict_frame ()이 끊는다. */
+	pml4_clear_page(pml4, page->va);
 
 	return true;
 }
@@ -74,21 +74,16 @@ file_backed_destroy (struct page *page) {
 	
 	struct file_page *file_page UNUSED = &page->file;
 
+	vm_wait_eviction(page);
 	if(pml4_is_dirty(thread_current()->pml4, page->va)){
 		file_write_at(file_page->file, file_page->upage, file_page->read_bytes, file_page->ofs);
 		pml4_set_dirty(thread_current()->pml4, page->va, false);
 	}
 
-	if(page->frame){
-		list_remove(&page->frame->elem);
-		page->frame->page = NULL;
-        free(page->frame);
-        page->frame = NULL;
-		
-	}
+	if(page->frame)
+		vm_frame_free(page->frame, true);
 	
-	pml4_clear_page(thread_current()->pml4, page->va);
-	hash_delete(&thread_current()->spt.spt_table, &page->elem);
+	hash_delete(&thread_current()->leader->spt.spt_table, &page->elem);
 }
 
 /* Do the mmap */
@@ -6,13 +6,20 @@
 #include "include/threads/vaddr.h"
 #include "include/threads/mmu.h"
 #include "include/threads/thread.h"
+#include "threads/interrupt.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+#include <stdio.h>
 
 /* frame table */
 struct list frame_table;
-struct list_elem *clock_hand;
+struct list_elem *clock_hand;   /* Next frame vm_scan_victim () looks at. */
 
 struct lock frame_lock;
 
+/* Threads waiting for a frame's eviction to finish. */
+static struct wait_queue evict_wq;
+
 void frame_table_init(void);
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
@@ -29,6 +36,7 @@ vm_init (void) {
 	/* TODO: Your code goes here. */
 	frame_table_init();
 	lock_init(&frame_lock);
+	wait_queue_init(&evict_wq);
 }
 
 /* frame table */
@@ -54,6 +62,7 @@ page_get_type (struct page *page) {
 /* Helpers */
 static struct frame *vm_get_victim (void);
 static bool vm_do_claim_page (struct page *page);
+static bool vm_claim_page_for (struct thread *owner, struct page *page);
 static struct frame *vm_evict_frame (void);
 
 /* Create the pending page object with initializer. If you want to create a
@@ -71,7 +80,7 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 	// printf("type: %d\n", type);
 	// printf("upage: %p\n", upage);
 	// printf("writable: %d\n", writable);
-	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
 			
 	/* Check wheter the upage is already occupied or not. */
 	if (spt_find_page (spt, upage) == NULL) {
@@ -138,62 +147,141 @@ spt_insert_page (struct supplemental_page_table *spt UNUSED,
 
 void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
+	void *va = page->va;
 	hash_delete(&spt->spt_table, &page->elem);
 	vm_dealloc_page (page);
-	return true;
+	/* The destructors leave the mapping alone (see hash_kill ()). */
+	pml4_clear_page(thread_current()->leader->pml4, va);
 }
 
-/* Get the struct frame, that will be evicted. */
-static struct frame *
-vm_get_victim (void) {
-	// lock_acquire(&frame_lock);
-	// struct frame *victim = NULL;
-	// //printf("vm_get_victim\n");
-	// /* clock algorithm */
-	// if(clock_hand == NULL) clock_hand = list_begin(&frame_table);
-	// // printf("get victim here\n");
-	// // printf("clock hand: %p\n", clock_hand);	
-	// // printf("frame table end: %p\n", list_end(&frame_table));
-	// // printf("frame table begin: %p\n", list_begin(&frame_table));
-	// struct thread *curr = thread_current();
-	// while(true){
-	// 	if(clock_hand == list_end(&frame_table)){
-	// 		clock_hand = list_begin(&frame_table);
-	// 	}
-	// 	// printf("clock hand: %p\n", clock_hand);	
-	// 	struct frame *f = list_entry(clock_hand, struct frame, elem);
-
-	// 	if(pml4_is_accessed(curr->pml4, f->page->va)){
-	// 		pml4_set_accessed(curr->pml4, f->page->va, false);
-	// 		clock_hand = list_next(clock_hand);
-	// 	}
-	// 	else{
-	// 		victim = list_entry(clock_hand, struct frame, elem);
-	// 		clock_hand = list_next(clock_hand);
-	// 		//printf("here\n");
-	// 		lock_release(&frame_lock);
-	// 		return victim;
-	// 	}
-		
-	// }
-	// lock_release(&frame_lock);
-	// return NULL;
+/* Working sets are resampled at most this often, in timer ticks. */
+#define WSS_SAMPLE_TICKS (TIMER_FREQ / 4)
 
-	struct frame *victim = NULL;
-    /* TODO: The policy for eviction is up to you. */
-    struct thread *curr = thread_current();
+/* Soft resident-frame limit given to new processes; see -rl. */
+size_t vm_frame_limit;
 
-    // Second Chance 방식으로 결정
-    struct list_elem *e = list_begin(&frame_table);
-    for (e; e != list_end(&frame_table); e = list_next(e)) {
-        victim = list_entry(e, struct frame, elem);
-        if (pml4_is_accessed(curr->pml4, victim->page->va))
-            pml4_set_accessed(curr->pml4, victim->page->va, false);  // pml4가 최근에 사용됐다면 기회를 한번 더 준다.
-        else
-            return victim;
-    }
+/* Tick of the last working set sample. */
+static int64_t wss_sampled_at;
+
+/* Moves F's accessed bit into both of its software copies, so that
+ * the clock and the working set sampler each see every access even
+ * though either may clear the hardware bit first. */
+static void
+frame_collect_accessed (struct frame *f) {
+	if (pml4_is_accessed (f->owner->pml4, f->page->va)) {
+		pml4_set_accessed (f->owner->pml4, f->page->va, false);
+		f->clock_ref = f->ws_ref = true;
+	}
+}
 
-    return list_entry(list_begin(&frame_table), struct frame, elem);
+/* Estimates each process's working set as the number of its frames
+ * accessed since the previous sample, smoothed against the last estimate.
+ * Rate limited to once every WSS_SAMPLE_TICKS. */
+static void
+vm_sample_working_sets (void) {
+	struct list_elem *e;
+	int64_t now = timer_ticks ();
+
+	if (now - wss_sampled_at < WSS_SAMPLE_TICKS)
+		return;
+	wss_sampled_at = now;
+
+	for (e = list_begin (&frame_table); e != list_end (&frame_table); e = list_next (e)) {
+		struct frame *f = list_entry (e, struct frame, elem);
+		if (f->owner != NULL)
+			f->owner->spt.ws_sample = 0;
+	}
+	for (e = list_begin (&frame_table); e != list_end (&frame_table); e = list_next (e)) {
+		struct frame *f = list_entry (e, struct frame, elem);
+		if (f->owner == NULL || f->page == NULL)
+			continue;
+		frame_collect_accessed (f);
+		if (f->ws_ref) {
+			f->ws_ref = false;
+			f->owner->spt.ws_sample++;
+		}
+	}
+	/* 프로세스마다 한 번만 갱신하도록 ws_sample을 SIZE_MAX로 표시한다. */
+	for (e = list_begin (&frame_table); e != list_end (&frame_table); e = list_next (e)) {
+		struct frame *f = list_entry (e, struct frame, elem);
+		if (f->owner == NULL || f->owner->spt.ws_sample == SIZE_MAX)
+			continue;
+		struct supplemental_page_table *spt = &f->owner->spt;
+		spt->wss = (spt->wss + spt->ws_sample + 1) / 2;
+		spt->ws_sample = SIZE_MAX;
+	}
+}
+
+/* Eviction preferences for vm_scan_victim (). */
+static bool
+over_frame_limit (struct frame *f) {
+	struct supplemental_page_table *spt = &f->owner->spt;
+	return spt->frame_limit != 0 && spt->resident_cnt > spt->frame_limit;
+}
+
+static bool
+over_working_set (struct frame *f) {
+	struct supplemental_page_table *spt = &f->owner->spt;
+	return spt->resident_cnt > spt->wss;
+}
+
+/* Returns the frame after E in clock order, wrapping around. */
+static struct list_elem *
+clock_next (struct list_elem *e) {
+	e = list_next (e);
+	return e == list_end (&frame_table) ? list_begin (&frame_table) : e;
+}
+
+/* Second chance scan over the unpinned frames, not already being evicted,
+ * that satisfy ELIGIBLE, or over every such frame if ELIGIBLE is null.
+ * Goes once around the frame table from clock_hand.  Returns the first
+ * frame not accessed since the hand last passed it, else the first
+ * eligible frame, else null, and leaves the hand just past the frame it
+ * returns. */
+static struct frame *
+vm_scan_victim (bool (*eligible) (struct frame *)) {
+	struct frame *fallback = NULL;
+	struct list_elem *e, *start;
+
+	if (list_empty (&frame_table))
+		return NULL;
+	if (clock_hand == NULL || clock_hand == list_end (&frame_table))
+		clock_hand = list_begin (&frame_table);
+
+	e = start = clock_hand;
+	do {
+		struct frame *f = list_entry (e, struct frame, elem);
+		e = clock_next (e);
+		if (f->pinned || f->evicting || f->page == NULL
+				|| (eligible != NULL && !eligible (f)))
+			continue;
+		frame_collect_accessed (f);
+		if (!f->clock_ref) {
+			clock_hand = e;
+			return f;
+		}
+		f->clock_ref = false;  // 최근에 사용됐다면 기회를 한번 더 준다.
+		if (fallback == NULL)
+			fallback = f;
+	} while (e != start);
+
+	if (fallback != NULL)
+		clock_hand = clock_next (&fallback->elem);
+	return fallback;
+}
+
+/* Get the struct frame, that will be evicted. */
+static struct frame *
+vm_get_victim (void) {
+	/* 메모리 한도를 넘은 프로세스, working set보다 많이 가진 프로세스,
+	   그 외 순서로 희생자를 찾는다.  working set은 그 전에 샘플링한다. */
+	struct frame *victim;
+
+	vm_sample_working_sets ();
+	if ((victim = vm_scan_victim (over_frame_limit)) == NULL
+			&& (victim = vm_scan_victim (over_working_set)) == NULL)
+		victim = vm_scan_victim (NULL);
+	return victim;
 }
 
 /* Evict one page and return the corresponding frame.
@@ -203,24 +291,96 @@ vm_get_victim (void) {
 // pml4에서의 연결만 해제해준다.
 static struct frame *
 vm_evict_frame (void) {
-	struct frame *victim UNUSED = vm_get_victim ();
+	enum intr_level old_level;
+	struct frame *victim;
+
+	/* vm_pin_user_range ()와 마찬가지로 인터럽트를 끈 채로 고르고
+	   evicting으로 표시한다.  swap_out ()이 디스크를 기다리는 동안
+	   이 frame은 pin되지 않는다. */
+	old_level = intr_disable ();
+	victim = vm_get_victim ();
+	if (victim != NULL)
+		victim->evicting = true;
+	intr_set_level (old_level);
 	if(!victim) return NULL;
 	
 	
 	struct page *page = victim->page;
+	struct thread *owner = victim->owner;
 	/* swap out */
 	swap_out(page);
 	// 매핑 해제
-	pml4_clear_page(thread_current()->pml4, page->va);
-	
+	pml4_clear_page(owner->pml4, page->va);
+
+	/* 다시 쓰기 전에 frame의 상태를 모두 초기화한다. */
+	old_level = intr_disable ();
+	owner->spt.resident_cnt--;
 	page->frame = NULL;
 	victim->page = NULL;
-	
-	//victim->page->frame = NULL;
+	victim->owner = NULL;
+	victim->pinned = false;
+	victim->evicting = false;
+	victim->clock_ref = victim->ws_ref = false;
+	intr_set_level (old_level);
+	wake_up_all (&evict_wq);
 
 	return victim;
 }
 
+/* wait_event () predicate: is PAGE_ no longer being evicted?  The
+ * evictor detaches the page and clears `evicting' together. */
+static bool
+page_evicted (void *page_) {
+	struct page *page = page_;
+	return page->frame == NULL || !page->frame->evicting;
+}
+
+/* Waits until an eviction of PAGE in progress, if any, is over.  Code
+ * that tears PAGE down calls this before it looks at PAGE's frame or swap
+ * slot, so that vm_evict_frame () never finds its victim's page, frame or
+ * owner freed under it while swap_out () waits for the disk.  Afterward
+ * PAGE is either resident and not being evicted, or not resident. */
+void
+vm_wait_eviction (struct page *page) {
+	enum intr_level old_level = intr_disable ();
+
+	if (!page_evicted (page))
+		wait_event (&evict_wq, page_evicted, page);
+	intr_set_level (old_level);
+}
+
+/* Links FRAME and PAGE and charges FRAME to the process OWNER. */
+static void
+vm_frame_attach (struct frame *frame, struct page *page, struct thread *owner) {
+	frame->page = page;
+	frame->owner = owner;
+	page->frame = frame;
+	frame->owner->spt.resident_cnt++;
+}
+
+/* Removes FRAME from the frame table and frees it, along with its kernel
+ * page if FREE_KVA.  FRAME must not be being evicted; see
+ * vm_wait_eviction ().  Callers that leave the page mapped pass false and let
+ * pml4_destroy () free it. */
+void
+vm_frame_free (struct frame *frame, bool free_kva) {
+	enum intr_level old_level = intr_disable ();
+
+	/* 호출한 쪽이 vm_wait_eviction ()으로 먼저 기다렸어야 한다. */
+	ASSERT (!frame->evicting);
+	if (clock_hand == &frame->elem)
+		clock_hand = list_next (clock_hand);
+	list_remove (&frame->elem);
+	intr_set_level (old_level);
+	if (frame->owner != NULL)
+		frame->owner->spt.resident_cnt--;
+	if (frame->page != NULL)
+		frame->page->frame = NULL;
+	if (free_kva)
+		palloc_free_page (frame->kva);
+	free (frame);
+}
+
 /* palloc() and get frame. If there is no available page, evict the page
  * and return it. This always return valid address. That is, if the user pool
  * memory is full, this function evicts the frame to get the available memory
@@ -236,14 +396,18 @@ vm_get_frame (void) {
 
 	void *p = palloc_get_page(PAL_USER);
 	if(p == NULL) {
+		free(frame);
 		struct frame *f = vm_evict_frame();
 		// printf("return evicted frame\n");
+		if(f == NULL) PANIC("no frame to evict: every frame is pinned");
 		return f;
 	}
 
 	frame->kva = p;
 
+	enum intr_level old_level = intr_disable ();
 	list_push_back(&frame_table, &frame->elem);
+	intr_set_level (old_level);
 
 	ASSERT (frame != NULL);
 	ASSERT (frame->page == NULL);
@@ -270,15 +434,80 @@ static bool
 vm_handle_wp (struct page *page UNUSED) {
 }
 
-/* Return true on success */
-/* 첫 번째 fault발생시 page에 물리 프레임할당해서 연결 */
-bool
-vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
-		bool user UNUSED, bool write UNUSED, bool not_present UNUSED) {
-	struct supplemental_page_table *spt UNUSED = &thread_current ()->spt;
+/* Page fault accounting, indexed by enum vm_fault_type. */
+static struct vm_fault_stat fault_stats[VM_FAULT_TYPE_CNT];
+
+/* Classifies the fault that claiming PAGE is about to service. */
+static enum vm_fault_type
+vm_fault_type_of (struct page *page) {
+	switch (VM_TYPE (page->operations->type)) {
+		case VM_UNINIT:
+			return VM_TYPE (page->uninit.type) == VM_FILE
+				? VM_FAULT_FILE : VM_FAULT_MINOR;
+		case VM_ANON:
+			return VM_FAULT_SWAP;
+		default:
+			return VM_FAULT_FILE;
+	}
+}
+
+/* Charges a fault of TYPE that took CYCLES TSC cycles. */
+static void
+vm_fault_account (enum vm_fault_type type, uint64_t cycles) {
+	struct vm_fault_stat *st = &fault_stats[type];
+	int bucket = cycles != 0 ? 63 - __builtin_clzll (cycles) : 0;
+	if (bucket >= VM_FAULT_HIST_BUCKETS)
+		bucket = VM_FAULT_HIST_BUCKETS - 1;
+
+	enum intr_level old_level = intr_disable ();
+	st->count++;
+	st->cycles += cycles;
+	if (cycles > st->max_cycles)
+		st->max_cycles = cycles;
+	st->hist[bucket]++;
+	intr_set_level (old_level);
+}
+
+/* Copies the counters for TYPE into ST. */
+void
+vm_get_fault_stat (enum vm_fault_type type, struct vm_fault_stat *st) {
+	ASSERT (type < VM_FAULT_TYPE_CNT);
+
+	enum intr_level old_level = intr_disable ();
+	*st = fault_stats[type];
+	intr_set_level (old_level);
+}
+
+/* Prints page fault statistics. */
+void
+vm_print_fault_stats (void) {
+	static const char *names[VM_FAULT_TYPE_CNT] = {
+		"minor", "file", "swap", "stack", "invalid",
+	};
+
+	for (int i = 0; i < VM_FAULT_TYPE_CNT; i++) {
+		const struct vm_fault_stat *st = &fault_stats[i];
+		if (st->count == 0)
+			continue;
+		printf ("VM: %llu %s faults, %llu avg / %llu max cycles\n",
+				st->count, names[i], st->cycles / st->count, st->max_cycles);
+		for (int b = 0; b < VM_FAULT_HIST_BUCKETS; b++)
+			if (st->hist[b] != 0)
+				printf ("VM:   %s [2^%d, 2^%d) cycles: %llu\n",
+						names[i], b, b + 1, st->hist[b]);
+	}
+}
+
+/* Services a page fault; see vm_try_handle_fault ().  Stores the class
+ * of the fault in *TYPE. */
+static bool
+vm_handle_fault (struct intr_frame *f, void *addr, bool user, bool write,
+		bool not_present, enum vm_fault_type *type) {
+	struct supplemental_page_table *spt UNUSED = &thread_current ()->leader->spt;
 	struct page *page = NULL;
 	// printf("vm fault handler addr: %p\n", addr);
 
+	*type = VM_FAULT_INVALID;
 	
 	/* valid address인지 확인 */
 	page = spt_find_page(spt, addr);
@@ -292,6 +521,7 @@ vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
 			if(((USER_STACK - (1 << 20)) <= addr && rsp <= addr && addr <= USER_STACK) ||
 				((USER_STACK - (1 << 20)) <= addr && addr >= rsp - 8 && addr <= USER_STACK)){
 				// 폴트난 addr에서 가장 가까운 1페이지 주소로 내림
+				*type = VM_FAULT_STACK;
 				vm_stack_growth(pg_round_down(addr));
 
 				return true;
@@ -301,11 +531,125 @@ vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
 	}
 	
 	if(write && !page->writable) return false;
+
+	/* 내보내는 중이면 끝날 때까지 기다렸다가 다시 올린다. */
+	vm_wait_eviction(page);
+
+	/* 같은 프로세스의 다른 스레드가 spt lock을 기다리는 동안 먼저
+	   이 페이지를 올렸다. */
+	if(page->frame != NULL) {
+		*type = VM_FAULT_MINOR;
+		return true;
+	}
 	
-	enum vm_type type = page->operations->type;
 	//printf("do claim\n");
 	//if(VM_TYPE(type) != VM_UNINIT) return false;
-	return vm_do_claim_page (page);
+	*type = vm_fault_type_of (page);
+	if (vm_do_claim_page (page))
+		return true;
+	*type = VM_FAULT_INVALID;
+	return false;
+}
+
+/* Return true on success */
+/* 첫 번째 fault발생시 page에 물리 프레임할당해서 연결 */
+bool
+vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
+		bool user UNUSED, bool write UNUSED, bool not_present UNUSED) {
+	struct lock *spt_lock = &thread_current ()->leader->spt.lock;
+	enum vm_fault_type type;
+	uint64_t start = rdtsc ();
+	bool success;
+
+	bool locked = !lock_held_by_current_thread (spt_lock);
+
+	if (locked)
+		lock_acquire (spt_lock);
+	success = vm_handle_fault (f, addr, user, write, not_present, &type);
+	if (locked)
+		lock_release (spt_lock);
+
+	vm_fault_account (type, rdtsc () - start);
+	return success;
+}
+
+/* wait_event () predicate: is FRAME_ no longer being evicted? */
+static bool
+frame_evicted (void *frame_) {
+	return !((struct frame *) frame_)->evicting;
+}
+
+/* Faults in every page of the user range [UADDR, UADDR + SIZE) and pins
+ * its frames so that they are not evicted until vm_unpin_user_range ().
+ * With WRITE, the range must be writable.  Lets a system call copy into
+ * or out of user memory without taking page faults while it holds
+ * locks.  Returns false, with nothing pinned, if part of the range is
+ * not valid user memory. */
+bool
+vm_pin_user_range (const void *uaddr, size_t size, bool write) {
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
+	void *start = pg_round_down (uaddr);
+	void *va;
+
+	if (size == 0)
+		return true;
+	if (!is_user_vaddr (uaddr) || !is_user_vaddr ((uint8_t *) uaddr + size - 1)
+			|| (uint8_t *) uaddr + size < (uint8_t *) uaddr)
+		return false;
+
+	/* SPT는 같은 프로세스의 다른 스레드가 바꿀 수 있다.  fault 처리기는
+	   이미 잡힌 lock을 그대로 쓰고 evictor는 이 lock을 잡지 않으므로,
+	   잡은 채로 fault를 처리하거나 eviction을 기다려도 된다. */
+	lock_acquire (&spt->lock);
+	for (va = start; va < (void *) ((uint8_t *) uaddr + size); va += PGSIZE) {
+		while (true) {
+			/* 인터럽트를 끈 채로 확인하고 pin해야 그 사이에 evict되지 않는다. */
+			enum intr_level old_level = intr_disable ();
+			struct page *page = spt_find_page (spt, va);
+			struct frame *frame = page != NULL ? page->frame : NULL;
+			bool resident = frame != NULL && !frame->evicting;
+			if (resident && !(write && !page->writable))
+				frame->pinned = true;
+			intr_set_level (old_level);
+
+			if (page != NULL && write && !page->writable)
+				goto fail;
+			if (frame != NULL && !resident) {
+				/* 내보내는 중인 frame은 끝난 뒤에 다시 fault로 올린다. */
+				wait_event (&evict_wq, frame_evicted, frame);
+				continue;
+			}
+			if (resident)
+				break;
+			if (!vm_try_handle_fault (NULL, va, false, write, true))
+				goto fail;
+		}
+	}
+	lock_release (&spt->lock);
+	return true;
+
+fail:
+	lock_release (&spt->lock);
+	vm_unpin_user_range (start, va - start);
+	return false;
+}
+
+/* Unpins the frames of the user range [UADDR, UADDR + SIZE). */
+void
+vm_unpin_user_range (const void *uaddr, size_t size) {
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
+	void *va;
+
+	if (size == 0)
+		return;
+	lock_acquire (&spt->lock);
+	for (va = pg_round_down (uaddr); va < (void *) ((uint8_t *) uaddr + size);
+			va += PGSIZE) {
+		struct page *page = spt_find_page (spt, va);
+		if (page != NULL && page->frame != NULL)
+			page->frame->pinned = false;
+	}
+	lock_release (&spt->lock);
 }
 
 /* Free the page.
@@ -322,7 +666,7 @@ vm_dealloc_page (struct page *page) {
 bool
 vm_claim_page (void *va UNUSED) {
 	struct page *page = NULL;
-	page = spt_find_page(&thread_current()->spt, va);
+	page = spt_find_page(&thread_current()->leader->spt, va);
 
 	return vm_do_claim_page (page);
 }
@@ -330,17 +674,23 @@ vm_claim_page (void *va UNUSED) {
 /* Claim the PAGE and set up the mmu. */
 static bool
 vm_do_claim_page (struct page *page) {
+	return vm_claim_page_for (thread_current ()->leader, page);
+}
+
+/* Claims PAGE of process OWNER, which need not be the current one, and
+ * maps it in OWNER's page table. */
+static bool
+vm_claim_page_for (struct thread *owner, struct page *page) {
 	struct frame *frame = vm_get_frame ();
 	//printf("get frame done\n");
 	/* Set links */
-	frame->page = page; 
-	page->frame = frame;
+	vm_frame_attach (frame, page, owner);
 	/* TODO: Insert page table entry to map page's VA to frame's PA. */
 	// printf("pml4_set_page\n");
 	// printf("page->writable: %d\n", page->writable);
 	// printf("page->va: %p\n", page->va);
 	// printf("kva: %p\n", page->frame->kva);
-	if(!pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->writable))
+	if(!pml4_set_page(owner->pml4, page->va, frame->kva, page->writable))
 		PANIC("set page fail");
 	
 	//printf("do claim page type: %d\n", page->operations->type);
@@ -348,6 +698,31 @@ vm_do_claim_page (struct page *page) {
 	return swap_in (page, frame->kva);
 }
 
+/* Makes PAGE of process OWNER resident and pins its frame so that it
+ * cannot be evicted while another process reads it.  Returns the frame,
+ * or a null pointer if PAGE could not be brought in.  *WAS_PINNED gets
+ * the frame's previous pin, for the caller to restore. */
+static struct frame *
+vm_pin_page (struct thread *owner, struct page *page, bool *was_pinned) {
+	while (true) {
+		enum intr_level old_level = intr_disable ();
+		struct frame *frame = page->frame;
+		bool resident = frame != NULL && !frame->evicting;
+		if (resident) {
+			*was_pinned = frame->pinned;
+			frame->pinned = true;
+		}
+		intr_set_level (old_level);
+
+		if (resident)
+			return frame;
+		if (frame != NULL)
+			vm_wait_eviction (page);
+		else if (!vm_claim_page_for (owner, page))
+			return NULL;
+	}
+}
+
 uint64_t hash_func(const struct hash_elem *e, void *aux){
 	struct page *page = hash_entry(e, struct page, elem);
 	return hash_bytes(&page->va, sizeof(page->va));
@@ -365,6 +740,12 @@ void
 supplemental_page_table_init (struct supplemental_page_table *spt UNUSED) {
 	
 	hash_init(&spt->spt_table, hash_func, hash_less, NULL);
+	lock_init(&spt->lock);
+	spt->resident_cnt = 0;
+	spt->frame_limit = vm_frame_limit;
+	spt->wss = 0;
+	spt->ws_sample = 0;
+	spt->owner = thread_current ();
 }
 
 /* Copy supplemental page table from src to dst */
@@ -372,6 +753,8 @@ bool
 supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		struct supplemental_page_table *src UNUSED) {
 
+	dst->frame_limit = src->frame_limit;
+
 	struct hash_iterator i;
 	hash_first(&i, &src->spt_table);
 	while(hash_next(&i)){
@@ -408,9 +791,15 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 					return false;
 			}
 
-			newpage->frame = vm_get_frame();
-			newpage->frame->page = newpage;
-			memcpy(newpage->frame->kva, page->frame->kva, PGSIZE);
+			/* 부모 페이지가 내보내져 있을 수 있고, 아래 vm_get_frame ()이
+			   부모 frame을 evict할 수도 있으므로 먼저 올려서 pin한다. */
+			bool was_pinned;
+			struct frame *src_frame = vm_pin_page(src->owner, page, &was_pinned);
+			if(src_frame == NULL)
+				return false;
+			vm_frame_attach(vm_get_frame(), newpage, thread_current()->leader);
+			memcpy(newpage->frame->kva, src_frame->kva, PGSIZE);
+			src_frame->pinned = was_pinned;
 			if(!spt_insert_page(&thread_current()->spt, newpage))
 				return false;
 			if(!pml4_set_page(thread_current()->pml4, newpage->va, newpage->frame->kva, newpage->writable))
@@ -421,13 +810,24 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 	return true;
 }
 
+/* Destructor used by supplemental_page_table_kill ().  The address space
+ * is going away, so a resident page stays mapped and pml4_destroy ()
+ * frees its frame together with the page tables in one walk.  Only the
+ * frame table entry is dropped here, which also keeps the page destructors
+ * from clearing and freeing each page on their own. */
 void hash_kill(struct hash_elem *e, void *aux){
 	struct page *page = hash_entry(e, struct page, elem);
+	vm_wait_eviction(page);
+	if(page->frame)
+		vm_frame_free(page->frame, false);
     destroy(page);
 	free(page);
 }
 
-/* Free the resource hold by the supplemental page table */
+/* Free the resource hold by the supplemental page table.
+ * Must run before the owning pml4 is destroyed: file-backed pages still
+ * consult its dirty bits, and resident frames are reclaimed by
+ * pml4_destroy (). */
 void
 supplemental_page_table_kill (struct supplemental_page_table *spt UNUSED) {
 	hash_clear(&spt->spt_table, hash_kill);